@@ -17,6 +17,7 @@ afficher_usage() {
     echo ""
     echo "Commandes disponibles :"
     echo "  histo {max|src|real|all}  - Generation d'histo usines"
+    echo "  histo contrib             - Matrice de contribution source x usine"
     echo "  leaks \"<identifiant>\"      - Calcul des fuites"
     echo ""
     echo "Exemples d'utilisation :"
@@ -38,6 +39,16 @@ afficher_duree() {
     echo "Duree totale d'execution : ${DUREE} ms"
 }
 
+# Les exports peuvent etre compresses (.dat.gz ou .dat.zst). Je regarde les premiers octets
+# et j'envoie le contenu decompresse sur la sortie standard, sans l'ecrire sur le disque.
+lire_donnees() {
+    case "$(head -c 4 "$1" | od -An -tx1 | tr -d ' \n')" in
+        1f8b*)    gzip -dc -- "$1" ;;
+        28b52ffd) zstd -dc -- "$1" ;;
+        *)        cat -- "$1" ;;
+    esac
+}
+
 # Je vérifie que l'utilisateur a bien tapé les bons arguments. 
 # S'il en manque ou s'il y en a trop, je l'arrête tout de suite. Je check aussi si le fichier de données existe.
 if [ "$#" -lt 2 ]; then
@@ -61,19 +72,18 @@ fi
 mkdir -p "$GRAPHS_DIR" "$TESTS_DIR" "$TEMP_DIR"
 
 # C'est l'étape de la compilation. Je vais dans le dossier du code C. 
-# Si le programme n'est pas déjà compilé, je lance 'make'. C'est plus simple que de tout compiler à la main à chaque fois.
+# Je lance toujours 'make' : il ne recompile que si un fichier source a change depuis la derniere fois.
 echo " Verification de la compilation "
 cd "$CODE_C_DIR" || erreur "Impossible d'acceder au repertoire codeC"
 
 if [ ! -f "wildwater" ]; then
     echo "Compilation du programme C avec make"
-    make
-    if [ $? -ne 0 ]; then
-        erreur "La compilation a echoue"
-    fi
-    echo "Compilation terminee avec succes"
 else
-    echo "L'executable wildwater existe deja"
+    echo "Mise a jour de l'executable wildwater si necessaire"
+fi
+make -s
+if [ $? -ne 0 ]; then
+    erreur "La compilation a echoue"
 fi
 
 cd "$SCRIPT_DIR" || erreur "Impossible de revenir au repertoire principal"
@@ -86,8 +96,8 @@ if [ "$COMMANDE" = "histo" ]; then
         erreur "La commande 'histo' necessite une option (max, src, real )"
     fi
     
-    if [[ "$OPTION" != "max" && "$OPTION" != "src" && "$OPTION" != "real" && "$OPTION" != "all" ]]; then
-        erreur "Option invalide : '$OPTION'. Options valides : max, src, real "
+    if [[ "$OPTION" != "max" && "$OPTION" != "src" && "$OPTION" != "real" && "$OPTION" != "all" && "$OPTION" != "contrib" ]]; then
+        erreur "Option invalide : '$OPTION'. Options valides : max, src, real, all, contrib "
     fi
     
     echo ""
@@ -100,11 +110,11 @@ if [ "$COMMANDE" = "histo" ]; then
     
     # Ici, je cherche les lignes des usines et des sources dans le fichier géant de départ.
     echo "  -> Extraction des capacites maximales des usines..."
-    grep -E "^-;(Plant #|Module #|Unit #|Facility complex #)" "$FICHIER_DONNEES" | \
+    lire_donnees "$FICHIER_DONNEES" | grep -E "^-;(Plant #|Module #|Unit #|Facility complex #)" | \
         grep -E ";-;[0-9]+;-$" > "$TEMP_DIR/usines.csv"
     
     echo "  -> Extraction des volumes captes par les sources..."
-    grep -E "^-;(Source #|Well #|Well field #|Spring #|Fountain #|Resurgence #)" "$FICHIER_DONNEES" | \
+    lire_donnees "$FICHIER_DONNEES" | grep -E "^-;(Source #|Well #|Well field #|Spring #|Fountain #|Resurgence #)" | \
         grep -E ";(Plant #|Module #|Unit #|Facility complex #)" > "$TEMP_DIR/captages.csv"
     
     NB_USINES=$(wc -l < "$TEMP_DIR/usines.csv")
@@ -130,6 +140,16 @@ if [ "$COMMANDE" = "histo" ]; then
     
     echo "Traitement des donnees termine avec succes"
     
+    # Pour la matrice de contribution il n'y a pas de graphique : une ligne par couple (usine, source).
+    if [ "$OPTION" = "contrib" ]; then
+        rm -f "$DONNEES_FILTREES" "$TEMP_DIR"/*.csv
+        echo ""
+        echo "=== Traitement termine avec succes ==="
+        echo "Fichier de donnees : $FICHIER_SORTIE"
+        afficher_duree
+        exit 0
+    fi
+    
     # Là, je prépare les fichiers pour faire les graphiques. Je trie tout ça pour isoler
     # les 50 plus petites usines et les 10 plus grandes pour que ce soit lisible sur l'image.
     echo "Preparation des donnees pour les graphiques..."
@@ -266,20 +286,36 @@ elif [ "$COMMANDE" = "leaks" ]; then
         echo "Creation du fichier de sortie avec en-tete"
     fi
     
+    # Si cette usine a deja ete calculee sur ce meme fichier (meme taille, meme date de modification),
+    # le resultat est dans le cache : pas besoin de filtrer ni de recalculer.
+    FICHIER_CACHE="$TESTS_DIR/leaks.cache"
+    if "$CODE_C_DIR/wildwater" leaks "$IDENTIFIANT_USINE" "$FICHIER_DONNEES" "$FICHIER_SORTIE" \
+        --cache "$FICHIER_CACHE" --cache-only; then
+        echo ""
+        echo "=== Resultat lu dans le cache ==="
+        echo "Resultat ajoute dans le fichier : $FICHIER_SORTIE"
+        echo ""
+        echo "Dernier resultat calcule :"
+        tail -1 "$FICHIER_SORTIE"
+        afficher_duree
+        exit 0
+    fi
+    
     echo "Filtrage des donnees pour l'usine..."
     
-    # J'extrais les captages, la distribution et les stockages liés à cette usine précise.
+    # Je lis le gros fichier une seule fois pour garder les lignes qui parlent de cette usine,
+    # puis j'extrais les captages, la distribution et les stockages de ce petit fichier.
+    lire_donnees "$FICHIER_DONNEES" | grep -F "$IDENTIFIANT_USINE" > "$TEMP_DIR/lignes_usine.csv"
+    
     echo "  -> Extraction des captages..."
-    grep -F "$IDENTIFIANT_USINE" "$FICHIER_DONNEES" | \
-        grep -E "^-;(Source #|Well #|Well field #|Spring #|Fountain #|Resurgence #)" > "$TEMP_DIR/captages_usine.csv"
+    grep -E "^-;(Source #|Well #|Well field #|Spring #|Fountain #|Resurgence #)" \
+        "$TEMP_DIR/lignes_usine.csv" > "$TEMP_DIR/captages_usine.csv"
     
     echo "  -> Extraction des troncons de distribution..."
-    grep -F "$IDENTIFIANT_USINE" "$FICHIER_DONNEES" | \
-        grep -v "^-;" > "$TEMP_DIR/distribution_usine.csv"
+    grep -v "^-;" "$TEMP_DIR/lignes_usine.csv" > "$TEMP_DIR/distribution_usine.csv"
     
     echo "  -> Extraction des stockages..."
-    grep -F "$IDENTIFIANT_USINE" "$FICHIER_DONNEES" | \
-        grep -E "^-;.*Storage" >> "$TEMP_DIR/distribution_usine.csv"
+    grep -E "^-;.*Storage" "$TEMP_DIR/lignes_usine.csv" >> "$TEMP_DIR/distribution_usine.csv"
     
     NB_CAPTAGES=$(awk 'END {print NR}' "$TEMP_DIR/captages_usine.csv" 2>/dev/null || echo "0")
     NB_DISTRIB=$(awk 'END {print NR}' "$TEMP_DIR/distribution_usine.csv" 2>/dev/null || echo "0")
@@ -290,14 +326,16 @@ elif [ "$COMMANDE" = "leaks" ]; then
     
     # J'envoie ces données filtrées au programme C pour obtenir le volume des fuites.
     echo "Appel du programme C pour le calcul des fuites..."
-    "$CODE_C_DIR/wildwater" leaks "$IDENTIFIANT_USINE" "$DONNEES_FILTREES" "$FICHIER_SORTIE"
+    # Le cache est indexe sur le fichier de donnees d'origine, pas sur le fichier filtre.
+    "$CODE_C_DIR/wildwater" leaks "$IDENTIFIANT_USINE" "$DONNEES_FILTREES" "$FICHIER_SORTIE" \
+        --cache "$FICHIER_CACHE" --key "$FICHIER_DONNEES" --cache-store
     
     if [ $? -ne 0 ]; then
         rm -f "$DONNEES_FILTREES" "$TEMP_DIR"/*.csv
         erreur "Le programme C a retourne une erreur"
     fi
     
-    rm -f "$DONNEES_FILTREES" "$TEMP_DIR/captages_usine.csv" "$TEMP_DIR/distribution_usine.csv"
+    rm -f "$DONNEES_FILTREES" "$TEMP_DIR/lignes_usine.csv" "$TEMP_DIR/captages_usine.csv" "$TEMP_DIR/distribution_usine.csv"
     
     echo ""
     echo "=== Calcul des fuites termine avec succes ==="
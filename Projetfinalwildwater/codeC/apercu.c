@@ -0,0 +1,309 @@
+/*
+  apercu.c - Top K approche des usines par Space-Saving
+
+  On garde au plus nbCompteurs usines. Une usine deja suivie voit son
+  compteur augmenter ; une nouvelle usine prend la place du plus petit
+  compteur (min) et demarre a min + volume, avec une erreur egale a min.
+  Pour chaque usine suivie : compteur - erreur <= volume reel <= compteur,
+  et toute usine de volume > min est forcement suivie.
+  Ces bornes valent pour les lignes lues : sur un echantillon (--sample),
+  elles sont extrapolees au fichier entier et ne sont plus que des estimations.
+
+  Les compteurs sont dans un tas-min (pour trouver le plus petit) et
+  une table de hachage a adressage ouvert (pour trouver une usine),
+  celle de lecture.h avec en plus la suppression.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+#include <sys/stat.h>
+#include "avl.h"
+#include "lecture.h"
+#include "apercu.h"
+
+typedef struct compteur {
+    char identifiant[50];
+    double volume;      // estimation (borne haute)
+    double erreur;      // sur-estimation maximale
+    int case_table;     // position dans la table de hachage
+} Compteur;
+
+typedef struct espaceSaving {
+    Compteur *tas;      // tas-min sur volume
+    int nb;
+    int capacite;
+    int *table;         // indice dans le tas ou CASE_VIDE
+    int tailleTable;    // puissance de 2
+} EspaceSaving;
+
+static void initialiserEspace(EspaceSaving *es, int capacite) {
+    int i;
+
+    es->capacite = capacite;
+    es->nb = 0;
+    es->tailleTable = 1;
+    while (es->tailleTable < 2 * capacite)
+        es->tailleTable *= 2;
+
+    es->tas = (Compteur*)malloc(sizeof(Compteur) * (size_t)capacite);
+    es->table = (int*)malloc(sizeof(int) * (size_t)es->tailleTable);
+    if (es->tas == NULL || es->table == NULL) {
+        fprintf(stderr, "Erreur: allocation memoire echouee pour l'apercu\n");
+        exit(EXIT_FAILURE);
+    }
+    for (i = 0; i < es->tailleTable; i++)
+        es->table[i] = CASE_VIDE;
+}
+
+static void libererEspace(EspaceSaving *es) {
+    free(es->tas);
+    free(es->table);
+}
+
+//      Table de hachage (sondage lineaire) 
+
+static int chercherCase(EspaceSaving *es, char *identifiant) {
+    return chercherCaseTable(es->table, es->tailleTable, identifiant, es->tas,
+                             sizeof(Compteur), offsetof(Compteur, identifiant));
+}
+
+// Suppression par decalage arriere : pas de marque "supprime" dans la table 
+static void supprimerCase(EspaceSaving *es, int i) {
+    int masque = es->tailleTable - 1;
+    int j = i, k;
+
+    es->table[i] = CASE_VIDE;
+    while (1) {
+        j = (j + 1) & masque;
+        if (es->table[j] == CASE_VIDE)
+            return;
+        k = caseIdeale(es->tas[es->table[j]].identifiant, es->tailleTable);
+        // on deplace j en i si sa case ideale k n'est pas entre i (exclu) et j 
+        if ((i <= j) ? (i < k && k <= j) : (i < k || k <= j))
+            continue;
+        es->table[i] = es->table[j];
+        es->tas[es->table[i]].case_table = i;
+        es->table[j] = CASE_VIDE;
+        i = j;
+    }
+}
+
+//      Tas-min 
+
+static void echanger(EspaceSaving *es, int a, int b) {
+    Compteur tmp = es->tas[a];
+    es->tas[a] = es->tas[b];
+    es->tas[b] = tmp;
+    es->table[es->tas[a].case_table] = a;
+    es->table[es->tas[b].case_table] = b;
+}
+
+static void descendre(EspaceSaving *es, int i) {
+    int plusPetit, g, d;
+
+    while (1) {
+        g = 2 * i + 1;
+        d = 2 * i + 2;
+        plusPetit = i;
+        if (g < es->nb && es->tas[g].volume < es->tas[plusPetit].volume)
+            plusPetit = g;
+        if (d < es->nb && es->tas[d].volume < es->tas[plusPetit].volume)
+            plusPetit = d;
+        if (plusPetit == i)
+            return;
+        echanger(es, i, plusPetit);
+        i = plusPetit;
+    }
+}
+
+static void monter(EspaceSaving *es, int i) {
+    while (i > 0 && es->tas[(i - 1) / 2].volume > es->tas[i].volume) {
+        echanger(es, i, (i - 1) / 2);
+        i = (i - 1) / 2;
+    }
+}
+
+static void ajouterVolume(EspaceSaving *es, char *identifiant, double volume) {
+    int c = chercherCase(es, identifiant);
+    int i;
+
+    // Usine deja suivie : le compteur augmente, il descend dans le tas-min 
+    if (es->table[c] != CASE_VIDE) {
+        i = es->table[c];
+        es->tas[i].volume += volume;
+        descendre(es, i);
+        return;
+    }
+
+    // Place libre 
+    if (es->nb < es->capacite) {
+        i = es->nb;
+        es->nb++;
+        strcpy(es->tas[i].identifiant, identifiant);
+        es->tas[i].volume = volume;
+        es->tas[i].erreur = 0.0;
+        es->tas[i].case_table = c;
+        es->table[c] = i;
+        monter(es, i);
+        return;
+    }
+
+    // On remplace le plus petit compteur (racine du tas) 
+    supprimerCase(es, es->tas[0].case_table);
+    c = chercherCase(es, identifiant);
+    es->tas[0].erreur = es->tas[0].volume;
+    es->tas[0].volume += volume;
+    strcpy(es->tas[0].identifiant, identifiant);
+    es->tas[0].case_table = c;
+    es->table[c] = 0;
+    descendre(es, 0);
+}
+
+static int comparerCompteurs(const void *a, const void *b) {
+    const Compteur *c1 = (const Compteur*)a;
+    const Compteur *c2 = (const Compteur*)b;
+    if (c1->volume < c2->volume)
+        return 1;
+    if (c1->volume > c2->volume)
+        return -1;
+    return strcmp(c1->identifiant, c2->identifiant);
+}
+
+//      Lecture (tout ou partie du fichier) 
+
+static void traiterEnregistrement(EspaceSaving *es, Enregistrement *e, int mode) {
+    Usine usine;
+
+    if (analyserEnregistrementHisto(e, &usine, NULL) != LIGNE_CAPTAGE)
+        return;
+    ajouterVolume(es, usine.identifiant,
+                  (mode == 2) ? usine.volume_capte : usine.volume_traite);
+}
+
+static void traiterLigne(EspaceSaving *es, char *ligne, int mode) {
+    Usine usine;
+
+    if (analyserLigneHisto(ligne, &usine, NULL) != LIGNE_CAPTAGE)
+        return;
+    ajouterVolume(es, usine.identifiant,
+                  (mode == 2) ? usine.volume_capte : usine.volume_traite);
+}
+
+/*
+ Lit la fraction demandee du fichier et renvoie la fraction reellement lue
+ (-1 si un bloc ne peut pas etre lu).
+ Fichier normal : on lit round(fraction * nbBlocs) blocs de 1 Mo (au moins un),
+ espaces regulierement sur tout le fichier. Fichier compresse (pas de fseek) :
+ une ligne sur 1/fraction ; les autres sont lues mais pas decoupees.
+ */
+static double lireEchantillon(FILE *f, int compresse, long taille, double fraction,
+                              EspaceSaving *es, int mode) {
+    Lecteur lecteur;
+    Decoupage decoupage = {0, -1, 0, 0};
+    Enregistrement *e;
+    char ligne[TAILLE_LIGNE];
+    long nbBlocs, nbLus, i, j, pas, numero = 0;
+
+    if (fraction >= 1.0 || (!compresse && taille <= TAILLE_BLOC_ECHANTILLON)) {
+        ouvrirLecteur(&lecteur, f, NULL, 0);
+        while ((e = lireEnregistrement(&lecteur)) != NULL)
+            traiterEnregistrement(es, e, mode);
+        fermerLecteur(&lecteur);
+        return 1.0;
+    }
+
+    if (compresse) {
+        pas = (long)(1.0 / fraction + 0.5);
+        while (fgets(ligne, TAILLE_LIGNE, f) != NULL) {
+            if (numero % pas == 0)
+                traiterLigne(es, ligne, mode);
+            numero++;
+        }
+        return 1.0 / (double)pas;
+    }
+
+    nbBlocs = (taille + TAILLE_BLOC_ECHANTILLON - 1) / TAILLE_BLOC_ECHANTILLON;
+    nbLus = (long)(fraction * (double)nbBlocs + 0.5);
+    if (nbLus < 1)
+        nbLus = 1;
+    for (j = 0; j < nbLus; j++) {
+        i = j * nbBlocs / nbLus;
+        decoupage.debut = i * TAILLE_BLOC_ECHANTILLON;
+        decoupage.fin = decoupage.debut + TAILLE_BLOC_ECHANTILLON;
+        if (ouvrirLecteur(&lecteur, f, &decoupage, 0) != 0)
+            return -1.0;
+        while ((e = lireEnregistrement(&lecteur)) != NULL)
+            traiterEnregistrement(es, e, mode);
+        fermerLecteur(&lecteur);
+    }
+    return (double)nbLus / (double)nbBlocs;
+}
+
+int traiterApercu(char *fichierEntree, char *fichierSortie, int mode,
+                  int top, long memoireKo, double fraction) {
+    FILE *fIn, *fOut;
+    pid_t pid;
+    struct stat infos;
+    EspaceSaving es;
+    double lu, echelle, minimum;
+    long taille = 0;
+    int capacite, i;
+
+    capacite = (int)(memoireKo * 1024L / (long)(sizeof(Compteur) + 2 * sizeof(int)));
+    if (capacite < top)
+        capacite = top;
+    if (fraction <= 0.0 || fraction > 1.0) {
+        fprintf(stderr, "Erreur: la fraction doit etre dans ]0, 1]\n");
+        return 1;
+    }
+
+    fIn = ouvrirEntree(fichierEntree, &pid);
+    if (fIn == NULL) {
+        fprintf(stderr, "Erreur: impossible d'ouvrir %s\n", fichierEntree);
+        return 1;
+    }
+    if (stat(fichierEntree, &infos) == 0)
+        taille = (long)infos.st_size;
+
+    if (pid != 0 && fraction < 1.0)
+        printf("Fichier compresse: tout le fichier est lu et decompresse, --sample ne reduit que le decoupage des lignes\n");
+
+    initialiserEspace(&es, capacite);
+    lu = lireEchantillon(fIn, pid != 0, taille, fraction, &es, mode);
+    if (fermerEntree(fIn, pid) != 0 || lu <= 0.0) {
+        if (lu <= 0.0)
+            fprintf(stderr, "Erreur: lecture de l'echantillon de %s impossible\n", fichierEntree);
+        libererEspace(&es);
+        return 1;
+    }
+
+    fOut = fopen(fichierSortie, "w");
+    if (fOut == NULL) {
+        fprintf(stderr, "Erreur:impossible de creer %s\n", fichierSortie);
+        libererEspace(&es);
+        return 1;
+    }
+
+    // Sur un echantillon, les volumes sont extrapoles au fichier entier 
+    echelle = 1.0 / lu;
+    minimum = (es.nb == es.capacite) ? es.tas[0].volume : 0.0;
+    qsort(es.tas, (size_t)es.nb, sizeof(Compteur), comparerCompteurs);
+
+    // Le minimum n'est garanti que si tout le fichier a ete lu 
+    fprintf(fOut, "identifier;%s volume estimate (M.m3.year-1);%s (M.m3.year-1)\n",
+            (mode == 2) ? "source" : "real", (lu >= 1.0) ? "minimum" : "minimum estimate");
+
+    for (i = 0; i < top && i < es.nb; i++) {
+        fprintf(fOut, "%s;%.6f;%.6f\n", es.tas[i].identifiant,
+                es.tas[i].volume * echelle / 1000.0,
+                (es.tas[i].volume - es.tas[i].erreur) * echelle / 1000.0);
+    }
+    fclose(fOut);
+
+    printf("Apercu: %d compteurs, %.1f%% du fichier lu, erreur max par usine %.6f M.m3\n",
+           es.capacite, 100.0 * lu, minimum * echelle / 1000.0);
+    libererEspace(&es);
+    return 0;
+}
@@ -0,0 +1,21 @@
+// Apercu rapide des plus grandes usines (top K) sur de tres gros fichiers :
+// algorithme Space-Saving avec un nombre fixe de compteurs (quelques Ko),
+// eventuellement sur une fraction du fichier seulement.
+
+#ifndef APERCU_H
+#define APERCU_H
+
+#define MEMOIRE_APERCU_DEFAUT_KO 64
+#define TOP_APERCU_DEFAUT 10
+// Taille des blocs lus quand on echantillonne une partie du fichier 
+#define TAILLE_BLOC_ECHANTILLON (1024L * 1024L)
+
+/*
+ mode: 2=src (volume capte), 3=real (volume traite)
+ top: nombre d'usines ecrites ; memoireKo: place pour les compteurs
+ fraction: part du fichier lue (1 = tout le fichier)
+ */
+int traiterApercu(char *fichierEntree, char *fichierSortie, int mode,
+                  int top, long memoireKo, double fraction);
+
+#endif
@@ -2,6 +2,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <math.h>
 #include "arbre_distrib.h"
 
 // structure utilisées (arbre_distrib.h) : 
@@ -46,15 +47,15 @@ static int min3Int(int a, int b, int c) {
 //Fonctions pour l'arbre de distribution
 
 
-Arbre* creerArbre(char *nom, float fuite) {
+Arbre* creerArbre(char *nom, double fuite) {
     Arbre *nouveau = (Arbre*)malloc(sizeof(Arbre));
     if (nouveau == NULL) {
         fprintf(stderr, "Erreur : allocation memoire echouee pour Arbre\n");
         exit(EXIT_FAILURE);
     }
-    strncpy(nouveau->nom, nom, 99);
-    nouveau->nom[99] = '\0';
-    nouveau->litre = 0.0f;
+    strncpy(nouveau->nom, nom, TAILLE_NOM_NOEUD - 1);
+    nouveau->nom[TAILLE_NOM_NOEUD - 1] = '\0';
+    nouveau->litre = 0.0;
     nouveau->fuite_cumule = fuite;
     nouveau->nombre_enfant = 0;
     nouveau->enfant = NULL;
@@ -98,8 +99,8 @@ AVL_Index* creerAVLIndex(char *nom, Arbre *adresse) {
         fprintf(stderr, "Erreur: allocation memoire echouee pour AVL_Index\n");
         exit(EXIT_FAILURE);
     }
-    strncpy(nouveau->nom, nom, 99);
-    nouveau->nom[99] = '\0';
+    strncpy(nouveau->nom, nom, TAILLE_NOM_NOEUD - 1);
+    nouveau->nom[TAILLE_NOM_NOEUD - 1] = '\0';
     nouveau->adresse = adresse;
     nouveau->eq = 0;
     nouveau->fg = NULL;
@@ -229,37 +230,223 @@ Arbre* rechercherAVLIndex(AVL_Index *racine, char *nom) {
 // on stock le volume dans le noeud 
 // on calcule les fuite
 // le volume est reparti entre les enfants 
-// appelle recusive pour chaque enfant
+// parcours en profondeur avec une pile (et non plus recursif) : les enfants
+// d'un noeud sont traites par lots, leurs pourcentages ranges dans un tableau
+// contigu pour que le compilateur vectorise le calcul des pertes.
+// export: si non NULL, une ligne par noeud au moment ou sa perte est calculee
+// Un noeud qui a peu d'enfants (cas courant : usagers, jonctions) est traite
+// directement sur sa liste, sans lot : remplir les tableaux couterait plus
+// que le calcul lui-meme.
+
+#define NB_VOIES 4
+#define TAILLE_PILE_INITIALE 1024
+#define TAILLE_LOT_FUITES 256
+#define SEUIL_LOT_FUITES 16     // nombre d'enfants a partir duquel on fait des lots
+
+// Somme compensee de Neumaier sur NB_VOIES sommes partielles independantes 
+typedef struct sommeCompensee {
+    double somme[NB_VOIES];
+    double compensation[NB_VOIES];
+} SommeCompensee;
+
+// Noeud dont il reste a traiter les enfants, avec le volume apres sa propre perte 
+typedef struct elementPile {
+    Arbre *noeud;
+    double sortie;
+} ElementPile;
+
+typedef struct pile {
+    ElementPile *elements;
+    int nb;
+    int capacite;
+} Pile;
+
+static void empiler(Pile *p, Arbre *noeud, double sortie) {
+    if (p->nb == p->capacite) {
+        p->capacite = (p->capacite == 0) ? TAILLE_PILE_INITIALE : 2 * p->capacite;
+        p->elements = (ElementPile*)realloc(p->elements, sizeof(ElementPile) * (size_t)p->capacite);
+        if (p->elements == NULL) {
+            fprintf(stderr, "Erreur: allocation memoire echouee pour le calcul des fuites\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+    p->elements[p->nb].noeud = noeud;
+    p->elements[p->nb].sortie = sortie;
+    p->nb++;
+}
 
-float calculerFuites(Arbre *racine, float volume_initial) {
-    float fuites = 0.0f;
-    float volume_apres_fuite;
-    float volume_par_enfant;
-    Chainon *c;
+/*
+ Noyau vectorisable : chaque enfant recoit part, en perd son pourcentage
+ et garde sortie pour ses propres enfants.
+ Pas de pointeur vers les noeuds ici, seulement des tableaux de double.
+ */
+static void calculerPertesEnfants(double part, const double *restrict pourcentage,
+                                  double *restrict perte, double *restrict sortie, int nb) {
+    int i;
+
+    for (i = 0; i < nb; i++) {
+        perte[i] = part * (pourcentage[i] / 100.0);
+        sortie[i] = part - perte[i];
+    }
+}
 
-    if (racine == NULL)
-        return 0.0f;
+// Neumaier : la compensation garde les chiffres perdus par chaque addition.
+// Les voies sont copiees en local pour que la boucle interne soit vectorisee.
+static void ajouterCompense(SommeCompensee *s, const double *restrict x, int nb) {
+    double somme[NB_VOIES], compensation[NB_VOIES], t[NB_VOIES];
+    double perdu_somme, perdu_x;
+    int i, v;
 
+    for (v = 0; v < NB_VOIES; v++) {
+        somme[v] = s->somme[v];
+        compensation[v] = s->compensation[v];
+    }
 
-    racine->litre = volume_initial;
+    for (i = 0; i + NB_VOIES <= nb; i += NB_VOIES) {
+        for (v = 0; v < NB_VOIES; v++) {
+            // les deux cas sont calcules puis choisis : pas de branche 
+            t[v] = somme[v] + x[i + v];
+            perdu_x = (somme[v] - t[v]) + x[i + v];
+            perdu_somme = (x[i + v] - t[v]) + somme[v];
+            compensation[v] += (fabs(somme[v]) >= fabs(x[i + v])) ? perdu_x : perdu_somme;
+            somme[v] = t[v];
+        }
+    }
+    for (v = 0; i < nb; i++, v++) {
+        t[v] = somme[v] + x[i];
+        perdu_x = (somme[v] - t[v]) + x[i];
+        perdu_somme = (x[i] - t[v]) + somme[v];
+        compensation[v] += (fabs(somme[v]) >= fabs(x[i])) ? perdu_x : perdu_somme;
+        somme[v] = t[v];
+    }
 
+    for (v = 0; v < NB_VOIES; v++) {
+        s->somme[v] = somme[v];
+        s->compensation[v] = compensation[v];
+    }
+}
 
-    fuites = volume_initial * (racine->fuite_cumule / 100.0f);
-    volume_apres_fuite = volume_initial - fuites;
+// Meme addition pour une seule valeur, hors des voies 
+static inline void ajouterCompenseSimple(double *somme, double *compensation, double x) {
+    double t = *somme + x;
 
+    if (fabs(*somme) >= fabs(x))
+        *compensation += (*somme - t) + x;
+    else
+        *compensation += (x - t) + *somme;
+    *somme = t;
+}
+
+// Inverse les n derniers elements de la pile 
+static void inverserSommet(Pile *p, int n) {
+    ElementPile tmp;
+    int i = p->nb - n, j = p->nb - 1;
+
+    while (i < j) {
+        tmp = p->elements[i];
+        p->elements[i] = p->elements[j];
+        p->elements[j] = tmp;
+        i++;
+        j--;
+    }
+}
+
+static double totalCompense(SommeCompensee *s) {
+    SommeCompensee total;
+    double compensation = 0.0;
+    int v;
+
+    memset(&total, 0, sizeof(SommeCompensee));
+    for (v = 0; v < NB_VOIES; v++) {
+        ajouterCompense(&total, &s->somme[v], 1);
+        compensation += s->compensation[v];
+    }
+    return total.somme[0] + (total.compensation[0] + compensation);
+}
+
+double calculerFuitesExport(Arbre *racine, double volume_initial, FILE *export) {
+    Pile pile = {NULL, 0, 0};
+    SommeCompensee fuites;
+    Arbre *enfants[TAILLE_LOT_FUITES];
+    double pourcentage[TAILLE_LOT_FUITES], perte[TAILLE_LOT_FUITES], sortie[TAILLE_LOT_FUITES];
+    ElementPile courant;
+    Chainon *c;
+    Arbre *enfant;
+    double part, perteEnfant;
+    double sommeSimple = 0.0, compensationSimple = 0.0;
+    int nb, i, avant;
+
+    if (racine == NULL)
+        return 0.0;
+
+    memset(&fuites, 0, sizeof(SommeCompensee));
+
+    // La racine recoit tout le volume 
+    racine->litre = volume_initial;
+    pourcentage[0] = racine->fuite_cumule;
+    calculerPertesEnfants(volume_initial, pourcentage, perte, sortie, 1);
+    ajouterCompense(&fuites, perte, 1);
+    if (export != NULL) {
+        fprintf(export, "%s;-;%.6f;%.6f\n", racine->nom, volume_initial / 1000.0, perte[0] / 1000.0);
+    }
+    if (racine->nombre_enfant > 0)
+        empiler(&pile, racine, sortie[0]);
+
+    while (pile.nb > 0) {
+        courant = pile.elements[--pile.nb];
+        part = courant.sortie / courant.noeud->nombre_enfant;
+        c = courant.noeud->enfant;
+
+        avant = pile.nb;
+
+        if (courant.noeud->nombre_enfant < SEUIL_LOT_FUITES) {
+            for (; c != NULL; c = c->suivant) {
+                enfant = c->a;
+                perteEnfant = part * (enfant->fuite_cumule / 100.0);
+                ajouterCompenseSimple(&sommeSimple, &compensationSimple, perteEnfant);
+                enfant->litre = part;
+                if (export != NULL) {
+                    fprintf(export, "%s;%s;%.6f;%.6f\n", enfant->nom, courant.noeud->nom,
+                            part / 1000.0, perteEnfant / 1000.0);
+                }
+                if (enfant->nombre_enfant > 0)
+                    empiler(&pile, enfant, part - perteEnfant);
+            }
+        }
 
-    if (racine->nombre_enfant > 0) {
-        volume_par_enfant = volume_apres_fuite / racine->nombre_enfant;
-        
-     
-        c = racine->enfant;
         while (c != NULL) {
-            fuites += calculerFuites(c->a, volume_par_enfant);
-            c = c->suivant;
+            // Rassembler un lot d'enfants dans des tableaux contigus 
+            for (nb = 0; nb < TAILLE_LOT_FUITES && c != NULL; nb++, c = c->suivant) {
+                enfants[nb] = c->a;
+                pourcentage[nb] = c->a->fuite_cumule;
+            }
+
+            calculerPertesEnfants(part, pourcentage, perte, sortie, nb);
+            ajouterCompense(&fuites, perte, nb);
+
+            for (i = 0; i < nb; i++) {
+                enfants[i]->litre = part;
+                if (export != NULL) {
+                    fprintf(export, "%s;%s;%.6f;%.6f\n", enfants[i]->nom, courant.noeud->nom,
+                            part / 1000.0, perte[i] / 1000.0);
+                }
+                if (enfants[i]->nombre_enfant > 0)
+                    empiler(&pile, enfants[i], sortie[i]);
+            }
         }
+
+        // Les enfants ressortent de la pile dans l'ordre de la liste 
+        inverserSommet(&pile, pile.nb - avant);
     }
 
-    return fuites;
+    free(pile.elements);
+    ajouterCompense(&fuites, &sommeSimple, 1);
+    fuites.compensation[0] += compensationSimple;
+    return totalCompense(&fuites);
+}
+
+double calculerFuites(Arbre *racine, double volume_initial) {
+    return calculerFuitesExport(racine, volume_initial, NULL);
 }
 
 // Libérer memoire 
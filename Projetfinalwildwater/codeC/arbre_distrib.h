@@ -6,17 +6,23 @@
 #ifndef ARBRE_DISTRIB_H
 #define ARBRE_DISTRIB_H
 
+#include <stdio.h>
+
 // anticipee 
 struct chainon;
 
+// Un nom vient d'une colonne du fichier (TAILLE_COLONNE, lecture.h) : 49 caracteres au plus.
+// Des noeuds plus petits passent mieux dans le cache pendant le calcul des fuites.
+#define TAILLE_NOM_NOEUD 50
+
  
  // Arbre de distribution
  
 
 typedef struct arbre {
-    char nom[100];              
-    float litre;                
-    float fuite_cumule;         
+    char nom[TAILLE_NOM_NOEUD];
+    double litre;               
+    double fuite_cumule;        
     int nombre_enfant;          
     struct chainon *enfant;     
 } Arbre;
@@ -37,14 +43,14 @@ typedef struct avl_index {
     int eq;                     
     struct avl_index *fg;      
     struct avl_index *fd;      
-    char nom[100];              
+    char nom[TAILLE_NOM_NOEUD];
     Arbre *adresse;             
 } AVL_Index;
 
 //       Fonctions pour l'arbre de distribution 
 
 
-Arbre* creerArbre(char *nom, float fuite);
+Arbre* creerArbre(char *nom, double fuite);
 
 
 void ajouterEnfant(Arbre *parent, Arbre *enfant);
@@ -62,8 +68,18 @@ Arbre* rechercherAVLIndex(AVL_Index *racine, char *nom);
 
 //      Calcul des fuites 
 
-// Calcule les fuites totales dans l'arbre de distribution 
-float calculerFuites(Arbre *racine, float volume_initial);
+/*
+ Calcule les fuites totales dans l'arbre de distribution, en double avec
+ une somme compensee (Neumaier) : les millions de petites pertes des
+ usagers ne perdent pas de chiffres dans le total.
+ */
+double calculerFuites(Arbre *racine, double volume_initial);
+
+/*
+ Meme calcul, en ecrivant dans export une ligne "noeud;parent;entree;perte"
+ (M.m3) par noeud pendant le parcours, sans autre structure en memoire.
+ */
+double calculerFuitesExport(Arbre *racine, double volume_initial, FILE *export);
 
 // Liberation memoire 
 
@@ -50,9 +50,38 @@ NoeudAVL* creerNoeud(Usine usine) {
     nouveau->fg = NULL;
     nouveau->fd = NULL;
     nouveau->eq = 0;  
+    mettreAJourNoeud(nouveau);
     return nouveau;
 }
 
+int tailleAVL(NoeudAVL *a) {
+    return (a == NULL) ? 0 : a->taille;
+}
+
+/*
+ taille = nombre d'usines du sous-arbre, somme_* = cumul de leurs volumes.
+ A appeler des qu'un fils ou les valeurs du noeud changent.
+ */
+void mettreAJourNoeud(NoeudAVL *a) {
+    a->taille = 1;
+    a->somme_max = a->usine.capacite_max;
+    a->somme_capte = a->usine.volume_capte;
+    a->somme_traite = a->usine.volume_traite;
+
+    if (a->fg != NULL) {
+        a->taille += a->fg->taille;
+        a->somme_max += a->fg->somme_max;
+        a->somme_capte += a->fg->somme_capte;
+        a->somme_traite += a->fg->somme_traite;
+    }
+    if (a->fd != NULL) {
+        a->taille += a->fd->taille;
+        a->somme_max += a->fd->somme_max;
+        a->somme_capte += a->fd->somme_capte;
+        a->somme_traite += a->fd->somme_traite;
+    }
+}
+
 // Rotations  gauche et droite
 
 
@@ -64,6 +93,8 @@ NoeudAVL* rotationGauche(NoeudAVL *a) {
     // Effectuer la rotation 
     a->fd = pivot->fg;
     pivot->fg = a;
+    mettreAJourNoeud(a);
+    mettreAJourNoeud(pivot);
 
 
     a->eq = eq_a - max(eq_p, 0) - 1;
@@ -80,6 +111,8 @@ NoeudAVL* rotationDroite(NoeudAVL *a) {
 
     a->fg = pivot->fd;
     pivot->fd = a;
+    mettreAJourNoeud(a);
+    mettreAJourNoeud(pivot);
 
  
     a->eq = eq_a - min(eq_p, 0) + 1;
@@ -133,6 +166,18 @@ NoeudAVL* equilibrerAVL(NoeudAVL *a) {
 
 //      Insertion  
 
+/*
+ Cumule une usine deja presente : la capacite max n'est remplacee
+ que si la nouvelle valeur est non nulle, les volumes s'additionnent.
+ */
+void fusionnerUsine(Usine *dest, Usine *usine) {
+    if (usine->capacite_max > 0) {
+        dest->capacite_max = usine->capacite_max;
+    }
+    dest->volume_capte += usine->volume_capte;
+    dest->volume_traite += usine->volume_traite;
+}
+
 /*
  Insere une usine dans l'AVL et reequilibre si necessaire
  h: pointeur pour indiquer si la hauteur a change
@@ -160,15 +205,15 @@ NoeudAVL* insererAVL(NoeudAVL *a, Usine usine, int *h) {
         a->fd = insererAVL(a->fd, usine, h);
     } else {
         
-        if (usine.capacite_max > 0) {
-            a->usine.capacite_max = usine.capacite_max;
-        }
-        a->usine.volume_capte += usine.volume_capte;
-        a->usine.volume_traite += usine.volume_traite;
+        fusionnerUsine(&a->usine, &usine);
+        mettreAJourNoeud(a);
         *h = 0;
         return a;
     }
 
+    // Un fils a change : taille et sommes du sous-arbre aussi 
+    mettreAJourNoeud(a);
+
     // Mise a jour du facteur d'equilibre et reequilibrage 
     if (*h != 0) {
         a->eq += *h;
@@ -198,6 +243,166 @@ NoeudAVL* rechercherAVL(NoeudAVL *racine, char *identifiant) {
         return rechercherAVL(racine->fd, identifiant);
 }
 
+//      Statistiques d'ordre 
+
+double valeurUsine(Usine *usine, int mode) {
+    if (mode == 1)
+        return usine->capacite_max;
+    if (mode == 2)
+        return usine->volume_capte;
+    if (mode == 3)
+        return usine->volume_traite;
+    return usine->volume_capte - usine->volume_traite;
+}
+
+// On descend en comptant les usines laissees a gauche 
+int rangAVL(NoeudAVL *racine, char *identifiant) {
+    int rang = 0;
+    int cmp;
+
+    while (racine != NULL) {
+        cmp = strcmp(identifiant, racine->usine.identifiant);
+        if (cmp <= 0) {
+            racine = racine->fg;
+        } else {
+            rang += tailleAVL(racine->fg) + 1;
+            racine = racine->fd;
+        }
+    }
+    return rang;
+}
+
+NoeudAVL* selectionnerAVL(NoeudAVL *racine, int k) {
+    int gauche;
+
+    while (racine != NULL) {
+        gauche = tailleAVL(racine->fg);
+        if (k < gauche) {
+            racine = racine->fg;
+        } else if (k == gauche) {
+            return racine;
+        } else {
+            k -= gauche + 1;
+            racine = racine->fd;
+        }
+    }
+    return NULL;
+}
+
+static void ajouterSomme(Usine *somme, NoeudAVL *a, int signe) {
+    somme->capacite_max += signe * a->somme_max;
+    somme->volume_capte += signe * a->somme_capte;
+    somme->volume_traite += signe * a->somme_traite;
+}
+
+static void ajouterUsine(Usine *somme, Usine *usine, int signe) {
+    somme->capacite_max += signe * usine->capacite_max;
+    somme->volume_capte += signe * usine->volume_capte;
+    somme->volume_traite += signe * usine->volume_traite;
+}
+
+/*
+ Cumule (signe = +1 ou -1) les usines d'identifiant < borne (ou <= borne si inclus),
+ renvoie leur nombre. Un seul chemin racine -> feuille : O(log n).
+ */
+static int sommeAvant(NoeudAVL *racine, char *borne, int inclus, Usine *somme, int signe) {
+    int nb = 0;
+    int cmp;
+
+    while (racine != NULL) {
+        cmp = strcmp(racine->usine.identifiant, borne);
+        if (cmp < 0 || (inclus && cmp == 0)) {
+            if (racine->fg != NULL) {
+                ajouterSomme(somme, racine->fg, signe);
+            }
+            ajouterUsine(somme, &racine->usine, signe);
+            nb += tailleAVL(racine->fg) + 1;
+            racine = racine->fd;
+        } else {
+            racine = racine->fg;
+        }
+    }
+    return nb;
+}
+
+int sommeIntervalleAVL(NoeudAVL *racine, char *debut, char *fin, Usine *somme) {
+    memset(somme, 0, sizeof(Usine));
+    if (strcmp(debut, fin) > 0)
+        return 0;
+    return sommeAvant(racine, fin, 1, somme, 1) - sommeAvant(racine, debut, 0, somme, -1);
+}
+
+// Ordre du classement : valeur croissante puis identifiant 
+static int comparerValeur(double valeur, char *identifiant, Usine *usine, int mode) {
+    double v = valeurUsine(usine, mode);
+    if (valeur < v)
+        return -1;
+    if (valeur > v)
+        return 1;
+    return strcmp(identifiant, usine->identifiant);
+}
+
+/*
+ Meme insertion que insererAVL mais la cle est (valeur selon le mode, identifiant).
+ Chaque usine n'est inseree qu'une fois (apres le cumul dans l'arbre des identifiants).
+ */
+NoeudAVL* insererAVLValeur(NoeudAVL *a, Usine usine, int mode, int *h) {
+    int cmp;
+
+    if (a == NULL) {
+        *h = 1;
+        return creerNoeud(usine);
+    }
+
+    cmp = comparerValeur(valeurUsine(&usine, mode), usine.identifiant, &a->usine, mode);
+
+    if (cmp < 0) {
+        a->fg = insererAVLValeur(a->fg, usine, mode, h);
+        *h = -*h;
+    } else if (cmp > 0) {
+        a->fd = insererAVLValeur(a->fd, usine, mode, h);
+    } else {
+        *h = 0;
+        return a;
+    }
+
+    mettreAJourNoeud(a);
+
+    if (*h != 0) {
+        a->eq += *h;
+        a = equilibrerAVL(a);
+        *h = (a->eq == 0) ? 0 : 1;
+    }
+
+    return a;
+}
+
+// Ajoute toutes les usines de racine dans l'arbre classe par valeur : O(n log n), une copie par usine 
+NoeudAVL* construireAVLValeur(NoeudAVL *racine, NoeudAVL *classement, int mode) {
+    int h = 0;
+
+    if (racine == NULL)
+        return classement;
+
+    classement = construireAVLValeur(racine->fg, classement, mode);
+    classement = insererAVLValeur(classement, racine->usine, mode, &h);
+    return construireAVLValeur(racine->fd, classement, mode);
+}
+
+int rangValeurAVL(NoeudAVL *racine, double valeur, char *identifiant, int mode) {
+    int rang = 0;
+
+    while (racine != NULL) {
+        if (comparerValeur(valeur, identifiant, &racine->usine, mode) <= 0) {
+            racine = racine->fg;
+        } else {
+            rang += tailleAVL(racine->fg) + 1;
+            racine = racine->fd;
+        }
+    }
+    return rang;
+}
+
 //       Parcours  :
 
 /* 
@@ -206,33 +411,92 @@ NoeudAVL* rechercherAVL(NoeudAVL *racine, char *identifiant) {
   Mode: 1=max, 2=src, 3=real, 4=all
  */
 void parcoursInverseAVL(NoeudAVL *racine, FILE *fichier, int mode) {
-    double valMax, valSrc, valReal;
-    
     if (racine == NULL)
         return;
 
 
     parcoursInverseAVL(racine->fd, fichier, mode);
 
-    
-    valMax = racine->usine.capacite_max / 1000.0;
-    valSrc = racine->usine.volume_capte / 1000.0;
-    valReal = racine->usine.volume_traite / 1000.0;
+    ecrireUsine(&racine->usine, fichier, mode);
+
+    parcoursInverseAVL(racine->fg, fichier, mode);
+}
+
+void intervallePrefixe(Intervalle *intervalle, char *prefixe) {
+    intervalle->debut = prefixe;
+    intervalle->fin = prefixe;
+    intervalle->longueurFin = strlen(prefixe);
+}
+
+// Bornes incluses 
+void intervalleBornes(Intervalle *intervalle, char *debut, char *fin) {
+    intervalle->debut = debut;
+    intervalle->fin = fin;
+    intervalle->longueurFin = sizeof(((Usine*)0)->identifiant);
+}
+
+/*
+ Parcours inverse limite a un intervalle : on ne descend a droite que si
+ le noeud est avant la fin, a gauche que s'il est apres le debut.
+ Seuls O(log n + k) noeuds sont visites pour k usines ecrites.
+ Renvoie le nombre d'usines ecrites.
+ */
+int parcoursInverseIntervalleAVL(NoeudAVL *racine, Intervalle *intervalle, FILE *fichier, int mode) {
+    int apresDebut, avantFin;
+    int nb = 0;
+
+    if (racine == NULL)
+        return 0;
+
+    apresDebut = strcmp(racine->usine.identifiant, intervalle->debut) >= 0;
+    avantFin = strncmp(racine->usine.identifiant, intervalle->fin, intervalle->longueurFin) <= 0;
+
+    if (avantFin)
+        nb += parcoursInverseIntervalleAVL(racine->fd, intervalle, fichier, mode);
+
+    if (apresDebut && avantFin) {
+        ecrireUsine(&racine->usine, fichier, mode);
+        nb++;
+    }
+
+    if (apresDebut)
+        nb += parcoursInverseIntervalleAVL(racine->fg, intervalle, fichier, mode);
+
+    return nb;
+}
+
+// En-tete des fichiers vol_<mode>.dat 
+void ecrireEnTeteHisto(FILE *fichier, int mode) {
+    if (mode == 1) {
+        fprintf(fichier, "identifier;max volume(M.m3.year-1)\n");
+    } else if (mode == 2) {
+        fprintf(fichier, "identifier;source volume (M.m3.year-1)\n");
+    } else if (mode == 3) {
+        fprintf(fichier, "identifier;real volume (M.m3.year-1)\n");
+    } else if (mode == 4) {
+        fprintf(fichier, "identifier;real volume;lost volume;available capacity\n");
+    }
+}
+
+// Ecrit la ligne d'une usine selon le mode (volumes en M.m3) 
+void ecrireUsine(Usine *usine, FILE *fichier, int mode) {
+    double valMax, valSrc, valReal;
+
+    valMax = usine->capacite_max / 1000.0;
+    valSrc = usine->volume_capte / 1000.0;
+    valReal = usine->volume_traite / 1000.0;
 
     // Ecrire selon le mode 
     if (mode == 1) {
-        fprintf(fichier, "%s;%.6f\n", racine->usine.identifiant, valMax);
+        fprintf(fichier, "%s;%.6f\n", usine->identifiant, valMax);
     } else if (mode == 2) {
-        fprintf(fichier, "%s;%.6f\n", racine->usine.identifiant, valSrc);
+        fprintf(fichier, "%s;%.6f\n", usine->identifiant, valSrc);
     } else if (mode == 3) {
-        fprintf(fichier, "%s;%.6f\n", racine->usine.identifiant, valReal);
+        fprintf(fichier, "%s;%.6f\n", usine->identifiant, valReal);
     } else if (mode == 4) {
         fprintf(fichier, "%s;%.6f;%.6f;%.6f \n", 
-                racine->usine.identifiant, valReal, valSrc - valReal, valMax - valSrc);
+                usine->identifiant, valReal, valSrc - valReal, valMax - valSrc);
     }
-
-    
-    parcoursInverseAVL(racine->fg, fichier, mode);
 }
 
 // liberer la memoire :
@@ -247,8 +511,7 @@ void libererAVL(NoeudAVL *racine) {
 }
 
 
+// La taille est tenue a jour dans chaque noeud 
 int compterNoeuds(NoeudAVL *racine) {
-    if (racine == NULL)
-        return 0;
-    return 1 + compterNoeuds(racine->fg) + compterNoeuds(racine->fd);
+    return tailleAVL(racine);
 }
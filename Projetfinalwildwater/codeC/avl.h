@@ -14,13 +14,29 @@ typedef struct Usine {
 } Usine;
 
 // Noeud de l'arbre AVL  
+// taille et somme_* portent sur tout le sous-arbre (statistiques d'ordre)
 typedef struct NoeudAVL {
     Usine usine;
     int eq;                    
+    int taille;
+    double somme_max;
+    double somme_capte;
+    double somme_traite;
     struct NoeudAVL *fg;       
     struct NoeudAVL *fd;      
 } NoeudAVL;
 
+/*
+ Intervalle d'identifiants pour les parcours partiels :
+ debut <= identifiant et strncmp(identifiant, fin, longueurFin) <= 0.
+ Pour un prefixe p : debut = fin = p et longueurFin = strlen(p).
+ */
+typedef struct intervalle {
+    char *debut;
+    char *fin;
+    size_t longueurFin;
+} Intervalle;
+
 // Fonctions 
 int max(int a, int b);
 int min(int a, int b);
@@ -30,6 +46,10 @@ int min3(int a, int b, int c);
 // Creation d'un noeud 
 NoeudAVL* creerNoeud(Usine usine);
 
+// Recalcule taille et sommes d'un noeud a partir de ses fils 
+void mettreAJourNoeud(NoeudAVL *a);
+int tailleAVL(NoeudAVL *a);
+
 // Rotations pour equilibrer l'AVL 
 NoeudAVL* rotationGauche(NoeudAVL *a);
 NoeudAVL* rotationDroite(NoeudAVL *a);
@@ -40,11 +60,33 @@ NoeudAVL* doubleRotationDroite(NoeudAVL *a);
 NoeudAVL* equilibrerAVL(NoeudAVL *a);
 
 //Operations principales 
+void fusionnerUsine(Usine *dest, Usine *usine);
 NoeudAVL* insererAVL(NoeudAVL *a, Usine usine, int *h);
 NoeudAVL* rechercherAVL(NoeudAVL *racine, char *identifiant);
 
+// Statistiques d'ordre en O(log n) 
+// Valeur d'une usine selon le mode: 1=max, 2=src, 3=real, 4=perdu (src - real)
+double valeurUsine(Usine *usine, int mode);
+// Nombre d'usines dont l'identifiant est avant identifiant 
+int rangAVL(NoeudAVL *racine, char *identifiant);
+// k-ieme usine dans l'ordre croissant de l'arbre (k commence a 0), NULL si hors limites 
+NoeudAVL* selectionnerAVL(NoeudAVL *racine, int k);
+// Somme des usines d'identifiant dans [debut, fin] (dans un Usine), renvoie leur nombre 
+int sommeIntervalleAVL(NoeudAVL *racine, char *debut, char *fin, Usine *somme);
+
+// Arbre classe par valeur (puis identifiant) pour les percentiles 
+NoeudAVL* insererAVLValeur(NoeudAVL *a, Usine usine, int mode, int *h);
+NoeudAVL* construireAVLValeur(NoeudAVL *racine, NoeudAVL *classement, int mode);
+// Nombre d'usines classees avant (valeur, identifiant) 
+int rangValeurAVL(NoeudAVL *racine, double valeur, char *identifiant, int mode);
+
 // Parcour et liberation 
 void parcoursInverseAVL(NoeudAVL *racine, FILE *fichier, int mode);
+void intervallePrefixe(Intervalle *intervalle, char *prefixe);
+void intervalleBornes(Intervalle *intervalle, char *debut, char *fin);
+int parcoursInverseIntervalleAVL(NoeudAVL *racine, Intervalle *intervalle, FILE *fichier, int mode);
+void ecrireEnTeteHisto(FILE *fichier, int mode);
+void ecrireUsine(Usine *usine, FILE *fichier, int mode);
 void libererAVL(NoeudAVL *racine);
 int compterNoeuds(NoeudAVL *racine);
 
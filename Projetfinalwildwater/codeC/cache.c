@@ -0,0 +1,271 @@
+/*
+  cache.c - Cache des fuites sur disque avec remplacement LRU
+
+  Le fichier cache contient l'entete, les compteurs (StatsCache) puis les
+  entrees. Une recherche ne prend qu'un verrou flock partage : elle lit les
+  entrees par blocs et, succes ou echec, ne reecrit sur place que les
+  compteurs et la date d'usage de l'entree trouvee (pwrite), sous un verrou
+  fcntl sur ces seuls octets. Un ajout prend le verrou exclusif, lit le
+  cache en entier, le modifie en memoire et le reecrit.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+#include "cache.h"
+
+// Entrees lues a la fois pendant une recherche 
+#define TAILLE_BLOC_CACHE 64
+#define POSITION_STATS TAILLE_ENTETE_CACHE
+#define POSITION_ENTREES (POSITION_STATS + (off_t)sizeof(StatsCache))
+
+typedef struct contenuCache {
+    StatsCache stats;
+    EntreeCache *entrees;
+} ContenuCache;
+
+int calculerEmpreinte(char *fichier, Empreinte *empreinte) {
+    struct stat infos;
+
+    if (stat(fichier, &infos) != 0)
+        return 1;
+
+    memset(empreinte, 0, sizeof(Empreinte));
+    empreinte->taille = (long long)infos.st_size;
+    empreinte->secondes = (long long)infos.st_mtim.tv_sec;
+    empreinte->nanosecondes = (long long)infos.st_mtim.tv_nsec;
+    empreinte->inode = (unsigned long long)infos.st_ino;
+    empreinte->peripherique = (unsigned long long)infos.st_dev;
+    return 0;
+}
+
+static int memeCle(EntreeCache *entree, Empreinte *empreinte, char *idUsine) {
+    return memcmp(&entree->empreinte, empreinte, sizeof(Empreinte)) == 0 &&
+           strcmp(entree->idUsine, idUsine) == 0;
+}
+
+// Ouvre le cache (le cree s'il n'existe pas) et le verrouille (LOCK_SH ou LOCK_EX) 
+static int ouvrirDescripteurCache(char *fichierCache, int verrou) {
+    int fd = open(fichierCache, O_RDWR | O_CREAT, 0644);
+
+    if (fd < 0) {
+        fprintf(stderr, "Erreur: impossible d'ouvrir le cache %s\n", fichierCache);
+        return -1;
+    }
+    flock(fd, verrou);
+    return fd;
+}
+
+static FILE* ouvrirCache(char *fichierCache) {
+    int fd = ouvrirDescripteurCache(fichierCache, LOCK_EX);
+    FILE *f;
+
+    if (fd < 0)
+        return NULL;
+    f = fdopen(fd, "r+b");
+    if (f == NULL)
+        close(fd);
+    return f;
+}
+
+// Lit tout le contenu ; un fichier vide ou invalide donne un cache vide 
+static void lireCache(FILE *f, ContenuCache *contenu) {
+    char entete[TAILLE_ENTETE_CACHE];
+    int n;
+
+    memset(&contenu->stats, 0, sizeof(StatsCache));
+    contenu->entrees = NULL;
+
+    if (fread(entete, 1, TAILLE_ENTETE_CACHE, f) != TAILLE_ENTETE_CACHE ||
+        memcmp(entete, ENTETE_CACHE, TAILLE_ENTETE_CACHE) != 0 ||
+        fread(&contenu->stats, sizeof(StatsCache), 1, f) != 1 ||
+        contenu->stats.nbEntrees < 0) {
+        memset(&contenu->stats, 0, sizeof(StatsCache));
+        return;
+    }
+
+    n = contenu->stats.nbEntrees;
+    if (n == 0)
+        return;
+    contenu->entrees = (EntreeCache*)malloc(sizeof(EntreeCache) * (size_t)n);
+    if (contenu->entrees == NULL ||
+        fread(contenu->entrees, sizeof(EntreeCache), (size_t)n, f) != (size_t)n) {
+        free(contenu->entrees);
+        contenu->entrees = NULL;
+        memset(&contenu->stats, 0, sizeof(StatsCache));
+    }
+}
+
+static void ecrireCache(FILE *f, ContenuCache *contenu) {
+    rewind(f);
+    fwrite(ENTETE_CACHE, 1, TAILLE_ENTETE_CACHE, f);
+    fwrite(&contenu->stats, sizeof(StatsCache), 1, f);
+    if (contenu->stats.nbEntrees > 0)
+        fwrite(contenu->entrees, sizeof(EntreeCache), (size_t)contenu->stats.nbEntrees, f);
+    fflush(f);
+    if (ftruncate(fileno(f), ftell(f)) != 0)
+        fprintf(stderr, "Attention: taille du cache non ajustee\n");
+}
+
+// Lit l'entete et les compteurs : 0 si le cache est valide 
+static int lireStats(int fd, StatsCache *stats) {
+    char entete[TAILLE_ENTETE_CACHE];
+
+    if (pread(fd, entete, TAILLE_ENTETE_CACHE, 0) != TAILLE_ENTETE_CACHE ||
+        memcmp(entete, ENTETE_CACHE, TAILLE_ENTETE_CACHE) != 0 ||
+        pread(fd, stats, sizeof(StatsCache), POSITION_STATS) != (ssize_t)sizeof(StatsCache) ||
+        stats->nbEntrees < 0)
+        return 1;
+    return 0;
+}
+
+// Verrou fcntl sur une plage d'octets (F_WRLCK ou F_UNLCK), independant du flock 
+static void verrouillerOctets(int fd, short type, off_t debut, off_t longueur) {
+    struct flock zone;
+
+    memset(&zone, 0, sizeof(zone));
+    zone.l_type = type;
+    zone.l_whence = SEEK_SET;
+    zone.l_start = debut;
+    zone.l_len = longueur;
+    fcntl(fd, F_SETLKW, &zone);
+}
+
+// Position de l'entree (empreinte, idUsine), -1 si absente 
+static int trouverEntree(int fd, int nbEntrees, Empreinte *empreinte, char *idUsine,
+                         double *fuites) {
+    EntreeCache bloc[TAILLE_BLOC_CACHE];
+    int i, n, debut;
+
+    for (debut = 0; debut < nbEntrees; debut += n) {
+        n = nbEntrees - debut;
+        if (n > TAILLE_BLOC_CACHE)
+            n = TAILLE_BLOC_CACHE;
+        if (pread(fd, bloc, sizeof(EntreeCache) * (size_t)n,
+                  POSITION_ENTREES + (off_t)sizeof(EntreeCache) * debut) !=
+            (ssize_t)(sizeof(EntreeCache) * (size_t)n))
+            return -1;
+        for (i = 0; i < n; i++) {
+            if (memeCle(&bloc[i], empreinte, idUsine)) {
+                *fuites = bloc[i].fuites;
+                return debut + i;
+            }
+        }
+    }
+    return -1;
+}
+
+int chercherCache(char *fichierCache, Empreinte *empreinte, char *idUsine,
+                  double *fuites, StatsCache *stats) {
+    StatsCache compteurs;
+    unsigned long long horloge;
+    int fd, position;
+
+    // Compteurs a zero si le cache ne peut pas etre ouvert 
+    if (stats != NULL)
+        memset(stats, 0, sizeof(StatsCache));
+
+    fd = ouvrirDescripteurCache(fichierCache, LOCK_SH);
+    if (fd < 0)
+        return 0;
+
+    // Cache vide ou invalide : on le (re)cree sous verrou exclusif 
+    if (lireStats(fd, &compteurs) != 0) {
+        flock(fd, LOCK_EX);
+        if (lireStats(fd, &compteurs) != 0) {
+            memset(&compteurs, 0, sizeof(StatsCache));
+            if (pwrite(fd, ENTETE_CACHE, TAILLE_ENTETE_CACHE, 0) != TAILLE_ENTETE_CACHE ||
+                pwrite(fd, &compteurs, sizeof(StatsCache), POSITION_STATS) != (ssize_t)sizeof(StatsCache) ||
+                ftruncate(fd, POSITION_ENTREES) != 0) {
+                fprintf(stderr, "Attention: cache %s non initialise\n", fichierCache);
+                close(fd);
+                return 0;
+            }
+        }
+        flock(fd, LOCK_SH);
+    }
+
+    // nbEntrees ne change que sous verrou exclusif : on peut chercher sans bloquer les autres lecteurs 
+    position = trouverEntree(fd, compteurs.nbEntrees, empreinte, idUsine, fuites);
+
+    // Seuls les compteurs et la date d'usage de l'entree sont reecrits 
+    verrouillerOctets(fd, F_WRLCK, POSITION_STATS, (off_t)sizeof(StatsCache));
+    if (lireStats(fd, &compteurs) == 0) {
+        horloge = ++compteurs.horloge;
+        if (position >= 0)
+            compteurs.succes++;
+        else
+            compteurs.echecs++;
+        if (pwrite(fd, &compteurs, sizeof(StatsCache), POSITION_STATS) != (ssize_t)sizeof(StatsCache) ||
+            (position >= 0 &&
+             pwrite(fd, &horloge, sizeof(horloge),
+                    POSITION_ENTREES + (off_t)sizeof(EntreeCache) * position +
+                    (off_t)offsetof(EntreeCache, dernierUsage)) != (ssize_t)sizeof(horloge)))
+            fprintf(stderr, "Attention: compteurs du cache non mis a jour\n");
+    }
+    verrouillerOctets(fd, F_UNLCK, POSITION_STATS, (off_t)sizeof(StatsCache));
+    close(fd);
+
+    if (stats != NULL)
+        *stats = compteurs;
+    return position >= 0;
+}
+
+int ajouterCache(char *fichierCache, Empreinte *empreinte, char *idUsine,
+                 double fuites, int capacite) {
+    FILE *f;
+    ContenuCache contenu;
+    EntreeCache *place = NULL;
+    EntreeCache *nouvelles;
+    int i;
+
+    f = ouvrirCache(fichierCache);
+    if (f == NULL)
+        return 1;
+    lireCache(f, &contenu);
+    contenu.stats.horloge++;
+
+    // Deja present (autre processus) : on remplace 
+    for (i = 0; i < contenu.stats.nbEntrees && place == NULL; i++) {
+        if (memeCle(&contenu.entrees[i], empreinte, idUsine))
+            place = &contenu.entrees[i];
+    }
+
+    if (place == NULL && contenu.stats.nbEntrees < capacite) {
+        nouvelles = (EntreeCache*)realloc(contenu.entrees,
+                        sizeof(EntreeCache) * (size_t)(contenu.stats.nbEntrees + 1));
+        if (nouvelles == NULL) {
+            free(contenu.entrees);
+            fclose(f);
+            return 1;
+        }
+        contenu.entrees = nouvelles;
+        place = &contenu.entrees[contenu.stats.nbEntrees];
+        contenu.stats.nbEntrees++;
+    }
+
+    // Cache plein : on remplace l'entree utilisee il y a le plus longtemps 
+    if (place == NULL) {
+        place = &contenu.entrees[0];
+        for (i = 1; i < contenu.stats.nbEntrees; i++) {
+            if (contenu.entrees[i].dernierUsage < place->dernierUsage)
+                place = &contenu.entrees[i];
+        }
+    }
+
+    memset(place, 0, sizeof(EntreeCache));
+    place->empreinte = *empreinte;
+    strncpy(place->idUsine, idUsine, sizeof(place->idUsine) - 1);
+    place->fuites = fuites;
+    place->dernierUsage = contenu.stats.horloge;
+
+    ecrireCache(f, &contenu);
+    fclose(f);
+    free(contenu.entrees);
+    return 0;
+}
@@ -0,0 +1,54 @@
+// Cache persistant des fuites calculees : cle = (empreinte du fichier de
+// donnees, identifiant d'usine). Tant que le fichier n'a pas change, une
+// nouvelle demande pour la meme usine est lue dans le cache sans recalcul.
+
+#ifndef CACHE_H
+#define CACHE_H
+
+#define CAPACITE_CACHE_DEFAUT 1024
+
+// Utilisation du cache par leaks 
+#define CACHE_CHERCHER 0        // cherche, calcule et ajoute si absent
+#define CACHE_LECTURE_SEULE 1   // cherche seulement (--cache-only)
+#define CACHE_ECRITURE_SEULE 2  // calcule et ajoute sans chercher (--cache-store)
+#define ENTETE_CACHE "WWCACHE2"
+#define TAILLE_ENTETE_CACHE 8
+
+// Empreinte d'un fichier : taille, date de modification et inode 
+typedef struct empreinte {
+    long long taille;
+    long long secondes;
+    long long nanosecondes;
+    unsigned long long inode;
+    unsigned long long peripherique;
+} Empreinte;
+
+typedef struct entreeCache {
+    Empreinte empreinte;
+    char idUsine[100];
+    double fuites;                  // -1 si l'usine n'existe pas
+    unsigned long long dernierUsage; // horloge du cache au dernier acces (LRU)
+} EntreeCache;
+
+// Compteurs gardes dans le fichier cache 
+typedef struct statsCache {
+    unsigned long long horloge;
+    unsigned long long succes;
+    unsigned long long echecs;
+    int nbEntrees;
+} StatsCache;
+
+int calculerEmpreinte(char *fichier, Empreinte *empreinte);
+
+/*
+ Cherche (empreinte, idUsine) : renvoie 1 et remplit fuites si trouve, 0 sinon.
+ Met a jour les compteurs et la date d'usage ; stats recoit les compteurs.
+ */
+int chercherCache(char *fichierCache, Empreinte *empreinte, char *idUsine,
+                  double *fuites, StatsCache *stats);
+
+// Ajoute un resultat ; si le cache est plein on retire l'entree la moins recemment utilisee 
+int ajouterCache(char *fichierCache, Empreinte *empreinte, char *idUsine,
+                 double fuites, int capacite);
+
+#endif
@@ -0,0 +1,197 @@
+/*
+  construction.c - Construction parallele de l'arbre de distribution
+
+  Le fichier est coupe en nbThreads plages d'octets (Decoupage, comme
+  --bytes) : chaque thread ouvre son propre FILE, decoupe ses lignes et
+  cree le noeud enfant de chaque arete de l'usine. Il garde ses aretes
+  (nom du parent, noeud enfant) et ses volumes captes dans l'ordre de sa
+  plage. Aucun lien n'est pose par les threads.
+
+  Apres les threads, on parcourt les plages dans l'ordre et on relie les
+  aretes avec la regle de traiterFuites : parent cherche dans l'AVL
+  d'index, arete ignoree (enfant libere) si le parent n'y est pas encore,
+  sinon enfant ajoute au parent puis insere dans l'index. Meme arbre,
+  memes enfants dans le meme ordre, donc le meme total au bit pres, quel
+  que soit nbThreads.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include "lecture.h"
+#include "construction.h"
+
+#define TAILLE_LISTE_INITIALE 256
+
+typedef struct areteLue {
+    char parent[TAILLE_COLONNE];
+    Arbre *enfant;          // cree par le thread, pas encore relie
+} AreteLue;
+
+typedef struct tacheConstruction {
+    pthread_t thread;
+    char *fichier;
+    char *idUsine;
+    Decoupage decoupage;
+    AreteLue *aretes;       // dans l'ordre de la plage
+    int nbAretes;
+    int capaciteAretes;
+    double *volumes;        // volume capte par ligne de captage, dans l'ordre
+    int nbVolumes;
+    int capaciteVolumes;
+    int usine_trouvee;
+    int erreur;
+} TacheConstruction;
+
+static void* agrandirListe(void *liste, int *capacite, size_t taille) {
+    *capacite = (*capacite == 0) ? TAILLE_LISTE_INITIALE : 2 * *capacite;
+    liste = realloc(liste, taille * (size_t)*capacite);
+    if (liste == NULL) {
+        fprintf(stderr, "Erreur: allocation memoire echouee pour la construction\n");
+        exit(EXIT_FAILURE);
+    }
+    return liste;
+}
+
+static void* executerConstruction(void *arg) {
+    TacheConstruction *t = (TacheConstruction*)arg;
+    FILE *f;
+    Lecteur lecteur;
+    Enregistrement *e;
+    AreteLue *arete;
+    double pourcentage;
+
+    f = fopen(t->fichier, "r");
+    if (f == NULL || ouvrirLecteur(&lecteur, f, &t->decoupage, 0) != 0) {
+        if (f != NULL)
+            fclose(f);
+        t->erreur = 1;
+        return NULL;
+    }
+
+    while ((e = lireEnregistrement(&lecteur)) != NULL) {
+        if (e->nbChamps < 2)
+            continue;
+
+        // Ligne source ->usine: -;Source;Usine;volume;pourcentage 
+        if (strcmp(e->col1, "-") == 0 && strcmp(e->col3, t->idUsine) == 0 &&
+            strlen(e->col4) > 0 && strcmp(e->col4, "-") != 0 &&
+            strlen(e->col5) > 0 && strcmp(e->col5, "-") != 0) {
+            double vol = atof(e->col4);
+            double fuite = atof(e->col5);
+            if (t->nbVolumes == t->capaciteVolumes)
+                t->volumes = (double*)agrandirListe(t->volumes, &t->capaciteVolumes, sizeof(double));
+            t->volumes[t->nbVolumes++] = vol * (1.0 - fuite / 100.0);
+            t->usine_trouvee = 1;
+        }
+
+        if (e->nbChamps < 3)
+            continue;
+
+        // Distribution de l'usine, ou usine -> stockage 
+        if ((strcmp(e->col1, t->idUsine) == 0) ||
+            (strcmp(e->col1, "-") == 0 && strcmp(e->col2, t->idUsine) == 0)) {
+            if (strlen(e->col3) == 0 || strcmp(e->col3, "-") == 0)
+                continue;
+            if (strlen(e->col5) > 0 && strcmp(e->col5, "-") != 0)
+                pourcentage = atof(e->col5);
+            else
+                pourcentage = 0.0;
+            if (t->nbAretes == t->capaciteAretes)
+                t->aretes = (AreteLue*)agrandirListe(t->aretes, &t->capaciteAretes, sizeof(AreteLue));
+            arete = &t->aretes[t->nbAretes++];
+            strcpy(arete->parent, e->col2);
+            arete->enfant = creerArbre(e->col3, pourcentage);
+        }
+    }
+
+    fermerLecteur(&lecteur);
+    fclose(f);
+    return NULL;
+}
+
+Arbre* construireArbreParallele(char *fichier, char *idUsine, int nbThreads, AVL_Index **racineIndex,
+                                double *volume_initial, int *usine_trouvee) {
+    TacheConstruction taches[NB_THREADS_MAX];
+    Arbre *racineArbre, *parent;
+    AreteLue *arete;
+    FILE *f;
+    long taille;
+    int i, j, h, lances = 0, erreur = 0;
+
+    if (nbThreads > NB_THREADS_MAX)
+        nbThreads = NB_THREADS_MAX;
+
+    f = fopen(fichier, "r");
+    if (f == NULL || fseek(f, 0, SEEK_END) != 0) {
+        if (f != NULL)
+            fclose(f);
+        fprintf(stderr, "Erreur: impossible d'ouvrir %s\n", fichier);
+        return NULL;
+    }
+    taille = ftell(f);
+    fclose(f);
+
+    racineArbre = creerArbre(idUsine, 0.0);
+    h = 0;
+    *racineIndex = insererAVLIndex(NULL, idUsine, racineArbre, &h);
+
+    for (i = 0; i < nbThreads; i++) {
+        taches[i].fichier = fichier;
+        taches[i].idUsine = idUsine;
+        taches[i].decoupage.debut = taille / nbThreads * i;
+        taches[i].decoupage.fin = (i == nbThreads - 1) ? -1 : taille / nbThreads * (i + 1);
+        taches[i].decoupage.shard = 0;
+        taches[i].decoupage.nbShards = 0;
+        taches[i].aretes = NULL;
+        taches[i].nbAretes = 0;
+        taches[i].capaciteAretes = 0;
+        taches[i].volumes = NULL;
+        taches[i].nbVolumes = 0;
+        taches[i].capaciteVolumes = 0;
+        taches[i].usine_trouvee = 0;
+        taches[i].erreur = 0;
+        if (pthread_create(&taches[i].thread, NULL, executerConstruction, &taches[i]) != 0) {
+            erreur = 1;
+            break;
+        }
+        lances++;
+    }
+
+    for (i = 0; i < lances; i++) {
+        pthread_join(taches[i].thread, NULL);
+        erreur |= taches[i].erreur;
+    }
+
+    // Ordre des plages = ordre du fichier : memes regles que la lecture sequentielle 
+    *volume_initial = 0.0;
+    *usine_trouvee = 0;
+    for (i = 0; i < lances; i++) {
+        for (j = 0; j < taches[i].nbAretes; j++) {
+            arete = &taches[i].aretes[j];
+            parent = rechercherAVLIndex(*racineIndex, arete->parent);
+            if (parent == NULL) {
+                libererArbre(arete->enfant);
+                continue;
+            }
+            ajouterEnfant(parent, arete->enfant);
+            h = 0;
+            *racineIndex = insererAVLIndex(*racineIndex, arete->enfant->nom, arete->enfant, &h);
+        }
+        for (j = 0; j < taches[i].nbVolumes; j++)
+            *volume_initial += taches[i].volumes[j];
+        *usine_trouvee |= taches[i].usine_trouvee;
+        free(taches[i].aretes);
+        free(taches[i].volumes);
+    }
+
+    if (erreur) {
+        fprintf(stderr, "Erreur: lecture parallele de %s impossible\n", fichier);
+        libererArbre(racineArbre);
+        libererAVLIndex(*racineIndex);
+        *racineIndex = NULL;
+        return NULL;
+    }
+    return racineArbre;
+}
@@ -0,0 +1,22 @@
+// Construction de l'arbre de distribution d'une usine sur plusieurs threads :
+// seules la lecture et la creation des noeuds se font en parallele. Les
+// enfants sont relies ensuite sur un seul thread, dans l'ordre du fichier et
+// avec la regle de la lecture sequentielle, d'ou le meme arbre.
+
+#ifndef CONSTRUCTION_H
+#define CONSTRUCTION_H
+
+#include "arbre_distrib.h"
+
+#define NB_THREADS_MAX 64
+
+/*
+ Lit fichier (non compresse : il faut fseek) avec nbThreads threads.
+ volume_initial / usine_trouvee : comme dans traiterFuites.
+ racineIndex recoit l'AVL d'index des noeuds de l'arbre.
+ Renvoie la racine (le noeud idUsine) ou NULL en cas d'erreur.
+ */
+Arbre* construireArbreParallele(char *fichier, char *idUsine, int nbThreads, AVL_Index **racineIndex,
+                                double *volume_initial, int *usine_trouvee);
+
+#endif
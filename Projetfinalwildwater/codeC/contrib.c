@@ -0,0 +1,167 @@
+/*
+  contrib.c - Matrice de contribution source x usine
+
+  traiterHistogramme cumule les captages dans l'Usine, on perd donc
+  l'identite de chaque source. Ici on garde un AVL a part, cle = (usine, source),
+  rempli pendant la meme lecture du fichier.
+  equilibre: eq = hauteur(fd) - hauteur(fg) (comme avl.c)
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "contrib.h"
+
+// compare d'abord l'usine puis la source 
+static int comparerContrib(Contribution *c1, Contribution *c2) {
+    int cmp = strcmp(c1->usine, c2->usine);
+    if (cmp != 0)
+        return cmp;
+    return strcmp(c1->source, c2->source);
+}
+
+static NoeudContrib* creerNoeudContrib(Contribution contrib) {
+    NoeudContrib *nouveau = (NoeudContrib*)malloc(sizeof(NoeudContrib));
+    if (nouveau == NULL) {
+        fprintf(stderr, "Erreur: allocation memoire echouee pour NoeudContrib\n");
+        exit(EXIT_FAILURE);
+    }
+    nouveau->contrib = contrib;
+    nouveau->eq = 0;
+    nouveau->fg = NULL;
+    nouveau->fd = NULL;
+    return nouveau;
+}
+
+static NoeudContrib* rotationGaucheContrib(NoeudContrib *a) {
+    NoeudContrib *pivot = a->fd;
+    int eq_a = a->eq;
+    int eq_p = pivot->eq;
+
+    a->fd = pivot->fg;
+    pivot->fg = a;
+
+    a->eq = eq_a - max(eq_p, 0) - 1;
+    pivot->eq = min3(eq_a - 2, eq_a + eq_p - 2, eq_p - 1);
+
+    return pivot;
+}
+
+static NoeudContrib* rotationDroiteContrib(NoeudContrib *a) {
+    NoeudContrib *pivot = a->fg;
+    int eq_a = a->eq;
+    int eq_p = pivot->eq;
+
+    a->fg = pivot->fd;
+    pivot->fd = a;
+
+    a->eq = eq_a - min(eq_p, 0) + 1;
+    pivot->eq = max3(eq_a + 2, eq_a + eq_p + 2, eq_p + 1);
+
+    return pivot;
+}
+
+static NoeudContrib* doubleRotationGaucheContrib(NoeudContrib *a) {
+    a->fd = rotationDroiteContrib(a->fd);
+    return rotationGaucheContrib(a);
+}
+
+static NoeudContrib* doubleRotationDroiteContrib(NoeudContrib *a) {
+    a->fg = rotationGaucheContrib(a->fg);
+    return rotationDroiteContrib(a);
+}
+
+static NoeudContrib* equilibrerContrib(NoeudContrib *a) {
+    if (a->eq >= 2) {
+        if (a->fd->eq >= 0) {
+            return rotationGaucheContrib(a);
+        } else {
+            return doubleRotationGaucheContrib(a);
+        }
+    } else if (a->eq <= -2) {
+        if (a->fg->eq <= 0) {
+            return rotationDroiteContrib(a);
+        } else {
+            return doubleRotationDroiteContrib(a);
+        }
+    }
+    return a;
+}
+
+// Meme principe que insererAVL : si le couple existe deja on cumule 
+NoeudContrib* insererContrib(NoeudContrib *a, Contribution contrib, int *h) {
+    int cmp;
+
+    if (a == NULL) {
+        *h = 1;
+        return creerNoeudContrib(contrib);
+    }
+
+    cmp = comparerContrib(&contrib, &a->contrib);
+
+    if (cmp < 0) {
+        a->fg = insererContrib(a->fg, contrib, h);
+        *h = -*h;
+    } else if (cmp > 0) {
+        a->fd = insererContrib(a->fd, contrib, h);
+    } else {
+        a->contrib.volume_capte += contrib.volume_capte;
+        a->contrib.volume_traite += contrib.volume_traite;
+        *h = 0;
+        return a;
+    }
+
+    if (*h != 0) {
+        a->eq += *h;
+        a = equilibrerContrib(a);
+        *h = (a->eq == 0) ? 0 : 1;
+    }
+
+    return a;
+}
+
+/*
+  Une ligne par couple : usine;source;capte;reel;perdu;part
+  Format en lignes choisi expres, a la place de colonnes groupees par usine :
+  une usine a un nombre variable de sources, donc une ligne par usine
+  n'aurait pas un nombre fixe de colonnes, alors que le script, sort,
+  gnuplot et un tableur lisent un enregistrement par ligne comme les
+  vol_*.dat. Les lignes d'une usine restent groupees (parcours par usine
+  puis source) et sont ecrites pendant le parcours, sans tampon par usine.
+  La matrice reste creuse (seuls les couples presents sont ecrits) ; le
+  prix est la repetition du nom de l'usine sur ses lignes.
+  Les volumes sont en M.m3 (divises par 1000 comme dans parcoursInverseAVL),
+  la part est le pourcentage du volume reel de l'usine qui vient de cette source.
+ */
+void parcoursInverseContrib(NoeudContrib *racine, NoeudAVL *racineUsines, FILE *fichier) {
+    NoeudAVL *usine;
+    double valSrc, valReal, part;
+
+    if (racine == NULL)
+        return;
+
+    parcoursInverseContrib(racine->fd, racineUsines, fichier);
+
+    valSrc = racine->contrib.volume_capte / 1000.0;
+    valReal = racine->contrib.volume_traite / 1000.0;
+
+    part = 0.0;
+    usine = rechercherAVL(racineUsines, racine->contrib.usine);
+    if (usine != NULL && usine->usine.volume_traite > 0) {
+        part = 100.0 * racine->contrib.volume_traite / usine->usine.volume_traite;
+    }
+
+    fprintf(fichier, "%s;%s;%.6f;%.6f;%.6f;%.3f\n",
+            racine->contrib.usine, racine->contrib.source,
+            valSrc, valReal, valSrc - valReal, part);
+
+    parcoursInverseContrib(racine->fg, racineUsines, fichier);
+}
+
+void libererContrib(NoeudContrib *racine) {
+    if (racine == NULL)
+        return;
+    libererContrib(racine->fg);
+    libererContrib(racine->fd);
+    free(racine);
+}
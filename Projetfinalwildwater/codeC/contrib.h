@@ -0,0 +1,37 @@
+// Matrice de contribution source x usine :
+// pour chaque couple (usine, source) on garde le volume capte et le volume traite.
+// La matrice est creuse : seuls les couples presents dans le fichier sont stockes,
+// dans un AVL trie par (usine, source).
+
+#ifndef CONTRIB_H
+#define CONTRIB_H
+
+#include <stdio.h>
+#include "avl.h"
+
+// Contribution d'une source a une usine 
+typedef struct Contribution {
+    char usine[50];
+    char source[50];
+    double volume_capte;
+    double volume_traite;
+} Contribution;
+
+// Noeud de l'AVL des contributions 
+typedef struct NoeudContrib {
+    Contribution contrib;
+    int eq;
+    struct NoeudContrib *fg;
+    struct NoeudContrib *fd;
+} NoeudContrib;
+
+// Insere un couple (usine, source), cumule les volumes si le couple existe deja 
+NoeudContrib* insererContrib(NoeudContrib *a, Contribution contrib, int *h);
+
+// Ecrit la matrice (ordre inverse comme les vol_*.dat), 
+// racineUsines sert a calculer la part de chaque source dans le volume reel de l'usine
+void parcoursInverseContrib(NoeudContrib *racine, NoeudAVL *racineUsines, FILE *fichier);
+
+void libererContrib(NoeudContrib *racine);
+
+#endif
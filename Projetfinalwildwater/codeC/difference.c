@@ -0,0 +1,236 @@
+/*
+  difference.c - Usines qui ont change entre deux versions des donnees
+
+  Au lieu de deux "histo all" puis d'un diff texte de vol_all.dat, on lit
+  chaque fichier une fois et on cumule ses lignes dans le meme AVL :
+  l'ancien fichier dans versions[0], le nouveau dans versions[1].
+  equilibre: eq = hauteur(fd) - hauteur(fg) (comme avl.c)
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "lecture.h"
+#include "difference.h"
+
+static NoeudDiff* creerNoeudDiff(Usine usine, int version) {
+    NoeudDiff *nouveau = (NoeudDiff*)malloc(sizeof(NoeudDiff));
+    if (nouveau == NULL) {
+        fprintf(stderr, "Erreur: allocation memoire echouee pour NoeudDiff\n");
+        exit(EXIT_FAILURE);
+    }
+    memset(nouveau, 0, sizeof(NoeudDiff));
+    strcpy(nouveau->versions[0].identifiant, usine.identifiant);
+    strcpy(nouveau->versions[1].identifiant, usine.identifiant);
+    nouveau->versions[version] = usine;
+    nouveau->presente[version] = 1;
+    nouveau->eq = 0;
+    nouveau->fg = NULL;
+    nouveau->fd = NULL;
+    return nouveau;
+}
+
+static NoeudDiff* rotationGaucheDiff(NoeudDiff *a) {
+    NoeudDiff *pivot = a->fd;
+    int eq_a = a->eq;
+    int eq_p = pivot->eq;
+
+    a->fd = pivot->fg;
+    pivot->fg = a;
+
+    a->eq = eq_a - max(eq_p, 0) - 1;
+    pivot->eq = min3(eq_a - 2, eq_a + eq_p - 2, eq_p - 1);
+
+    return pivot;
+}
+
+static NoeudDiff* rotationDroiteDiff(NoeudDiff *a) {
+    NoeudDiff *pivot = a->fg;
+    int eq_a = a->eq;
+    int eq_p = pivot->eq;
+
+    a->fg = pivot->fd;
+    pivot->fd = a;
+
+    a->eq = eq_a - min(eq_p, 0) + 1;
+    pivot->eq = max3(eq_a + 2, eq_a + eq_p + 2, eq_p + 1);
+
+    return pivot;
+}
+
+static NoeudDiff* doubleRotationGaucheDiff(NoeudDiff *a) {
+    a->fd = rotationDroiteDiff(a->fd);
+    return rotationGaucheDiff(a);
+}
+
+static NoeudDiff* doubleRotationDroiteDiff(NoeudDiff *a) {
+    a->fg = rotationGaucheDiff(a->fg);
+    return rotationDroiteDiff(a);
+}
+
+static NoeudDiff* equilibrerDiff(NoeudDiff *a) {
+    if (a->eq >= 2) {
+        if (a->fd->eq >= 0) {
+            return rotationGaucheDiff(a);
+        } else {
+            return doubleRotationGaucheDiff(a);
+        }
+    } else if (a->eq <= -2) {
+        if (a->fg->eq <= 0) {
+            return rotationDroiteDiff(a);
+        } else {
+            return doubleRotationDroiteDiff(a);
+        }
+    }
+    return a;
+}
+
+NoeudDiff* insererDiff(NoeudDiff *a, Usine usine, int version, int *h) {
+    int cmp;
+
+    if (a == NULL) {
+        *h = 1;
+        return creerNoeudDiff(usine, version);
+    }
+
+    cmp = strcmp(usine.identifiant, a->versions[0].identifiant);
+
+    if (cmp < 0) {
+        a->fg = insererDiff(a->fg, usine, version, h);
+        *h = -*h;
+    } else if (cmp > 0) {
+        a->fd = insererDiff(a->fd, usine, version, h);
+    } else {
+        fusionnerUsine(&a->versions[version], &usine);
+        a->presente[version] = 1;
+        *h = 0;
+        return a;
+    }
+
+    if (*h != 0) {
+        a->eq += *h;
+        a = equilibrerDiff(a);
+        *h = (a->eq == 0) ? 0 : 1;
+    }
+
+    return a;
+}
+
+void libererDiff(NoeudDiff *racine) {
+    if (racine == NULL)
+        return;
+    libererDiff(racine->fg);
+    libererDiff(racine->fd);
+    free(racine);
+}
+
+// Une lecture du fichier, cumulee dans l'emplacement version 
+static int lireVersion(char *fichier, NoeudDiff **racine, int version) {
+    FILE *f;
+    pid_t pid;
+    Lecteur lecteur;
+    Enregistrement *e;
+    Usine usine;
+    int h;
+
+    f = ouvrirEntree(fichier, &pid);
+    if (f == NULL) {
+        fprintf(stderr, "Erreur: impossible d'ouvrir %s\n", fichier);
+        return 1;
+    }
+    ouvrirLecteur(&lecteur, f, NULL, 0);
+    while ((e = lireEnregistrement(&lecteur)) != NULL) {
+        if (analyserEnregistrementHisto(e, &usine, NULL) == LIGNE_IGNOREE)
+            continue;
+        h = 0;
+        *racine = insererDiff(*racine, usine, version, &h);
+    }
+    fermerLecteur(&lecteur);
+    return fermerEntree(f, pid);
+}
+
+typedef struct bilanDiff {
+    long ajoutees;
+    long supprimees;
+    long modifiees;
+    long identiques;
+} BilanDiff;
+
+static int different(double ancien, double nouveau) {
+    return fabs(nouveau - ancien) >= SEUIL_DIFFERENCE;
+}
+
+/*
+ Ordre inverse comme vol_all.dat. Pour chaque valeur : nouvelle valeur
+ et ecart (nouveau - ancien), en M.m3 ; perdu = capte - traite.
+ */
+static void ecrireDifferences(NoeudDiff *racine, FILE *fichier, BilanDiff *bilan) {
+    Usine *a, *n;
+    const char *etat;
+
+    if (racine == NULL)
+        return;
+
+    ecrireDifferences(racine->fd, fichier, bilan);
+
+    a = &racine->versions[VERSION_ANCIENNE];
+    n = &racine->versions[VERSION_NOUVELLE];
+    if (!racine->presente[VERSION_ANCIENNE]) {
+        etat = "added";
+        bilan->ajoutees++;
+    } else if (!racine->presente[VERSION_NOUVELLE]) {
+        etat = "removed";
+        bilan->supprimees++;
+    } else if (different(a->capacite_max, n->capacite_max) ||
+               different(a->volume_capte, n->volume_capte) ||
+               different(a->volume_traite, n->volume_traite)) {
+        etat = "changed";
+        bilan->modifiees++;
+    } else {
+        etat = NULL;
+        bilan->identiques++;
+    }
+
+    if (etat != NULL) {
+        fprintf(fichier, "%s;%s;%.6f;%.6f;%.6f;%.6f;%.6f;%.6f;%.6f;%.6f\n",
+                n->identifiant, etat,
+                n->capacite_max / 1000.0, (n->capacite_max - a->capacite_max) / 1000.0,
+                n->volume_capte / 1000.0, (n->volume_capte - a->volume_capte) / 1000.0,
+                n->volume_traite / 1000.0, (n->volume_traite - a->volume_traite) / 1000.0,
+                (n->volume_capte - n->volume_traite) / 1000.0,
+                ((n->volume_capte - n->volume_traite) - (a->volume_capte - a->volume_traite)) / 1000.0);
+    }
+
+    ecrireDifferences(racine->fg, fichier, bilan);
+}
+
+int traiterDifference(char *fichierAncien, char *fichierNouveau, char *fichierSortie) {
+    NoeudDiff *racine = NULL;
+    BilanDiff bilan = {0, 0, 0, 0};
+    FILE *fOut;
+
+    if (lireVersion(fichierAncien, &racine, VERSION_ANCIENNE) != 0 ||
+        lireVersion(fichierNouveau, &racine, VERSION_NOUVELLE) != 0) {
+        libererDiff(racine);
+        return 1;
+    }
+
+    fOut = fopen(fichierSortie, "w");
+    if (fOut == NULL) {
+        fprintf(stderr, "Erreur:impossible de creer %s\n", fichierSortie);
+        libererDiff(racine);
+        return 1;
+    }
+    fprintf(fOut, "identifier;status;max volume (M.m3.year-1);max delta;"
+                  "source volume (M.m3.year-1);source delta;"
+                  "real volume (M.m3.year-1);real delta;"
+                  "lost volume (M.m3.year-1);lost delta\n");
+    ecrireDifferences(racine, fOut, &bilan);
+    fclose(fOut);
+
+    printf("Difference: %ld ajoutee(s), %ld supprimee(s), %ld modifiee(s), %ld identique(s)\n",
+           bilan.ajoutees, bilan.supprimees, bilan.modifiees, bilan.identiques);
+    libererDiff(racine);
+    return 0;
+}
@@ -0,0 +1,33 @@
+// Comparaison de deux versions du fichier de donnees :
+// un seul AVL d'usines avec deux emplacements par usine (ancien, nouveau),
+// on n'ecrit que les usines qui ont change.
+
+#ifndef DIFFERENCE_H
+#define DIFFERENCE_H
+
+#include "avl.h"
+
+#define VERSION_ANCIENNE 0
+#define VERSION_NOUVELLE 1
+
+// Ecart minimal affiche (k.m3) : en dessous, l'ecart ne se voit pas au format %.6f en M.m3 
+#define SEUIL_DIFFERENCE 0.0005
+
+// Noeud de l'AVL des differences 
+typedef struct NoeudDiff {
+    Usine versions[2];
+    int presente[2];
+    int eq;
+    struct NoeudDiff *fg;
+    struct NoeudDiff *fd;
+} NoeudDiff;
+
+// Cumule usine dans l'emplacement version (comme insererAVL) 
+NoeudDiff* insererDiff(NoeudDiff *a, Usine usine, int version, int *h);
+
+void libererDiff(NoeudDiff *racine);
+
+// Lit les deux fichiers et ecrit les usines ajoutees, supprimees ou modifiees 
+int traiterDifference(char *fichierAncien, char *fichierNouveau, char *fichierSortie);
+
+#endif
@@ -0,0 +1,315 @@
+/*
+  externe.c - Agregation de l'histogramme hors memoire
+
+  1) lecture du fichier : chaque ligne d'usine ou de captage devient un Usine,
+     ecrit (en binaire) dans la partition hachage(identifiant) % nbPartitions
+  2) chaque partition est relue et agregee dans un AVL (insererAVL, donc
+     memes regles de cumul). Toutes les lignes d'une usine sont dans la meme
+     partition et dans l'ordre du fichier : le resultat est identique.
+     Si une partition a trop d'usines pour le budget, elle est re-partitionnee
+     avec une autre graine de hachage.
+  3) chaque AVL est ecrit trie (ordre inverse) dans un "run" temporaire,
+     puis les runs sont fusionnes pour produire vol_<mode>.dat.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include "avl.h"
+#include "lecture.h"
+#include "externe.h"
+
+// Place prise par une usine dans l'AVL (noeud + entete de malloc) 
+#define TAILLE_NOEUD_ESTIMEE (sizeof(NoeudAVL) + 16)
+// Taille minimale d'une ligne utile du fichier, pour estimer le nombre d'usines 
+#define TAILLE_LIGNE_MIN 32
+// Taux de compression estime d'un fichier gzip/zstd de donnees 
+#define TAUX_COMPRESSION 8
+
+// Liste des runs tries en attente de fusion 
+typedef struct runs {
+    FILE *fichiers[NB_PARTITIONS_MAX];
+    int nb;
+} Runs;
+
+static FILE* creerTemporaire(void) {
+    FILE *f = tmpfile();
+    if (f == NULL) {
+        fprintf(stderr, "Erreur: impossible de creer un fichier temporaire\n");
+        exit(EXIT_FAILURE);
+    }
+    return f;
+}
+
+/*
+ Les ecritures dans les fichiers temporaires peuvent echouer (/tmp plein,
+ justement sur les gros fichiers) : toutes les fonctions qui ecrivent
+ renvoient 1 en cas d'erreur, et le resultat n'est pas ecrit.
+ */
+static int ecrireBinaire(Usine *usine, FILE *f) {
+    if (fwrite(usine, sizeof(Usine), 1, f) != 1) {
+        fprintf(stderr, "Erreur: ecriture d'un fichier temporaire impossible (disque plein ?)\n");
+        return 1;
+    }
+    return 0;
+}
+
+// Vide le tampon et verifie qu'aucune ecriture n'a echoue avant de relire le fichier 
+static int verifierTemporaire(FILE *f) {
+    if (fflush(f) != 0 || ferror(f)) {
+        fprintf(stderr, "Erreur: ecriture d'un fichier temporaire impossible (disque plein ?)\n");
+        return 1;
+    }
+    return 0;
+}
+
+// Ecrit l'AVL en ordre inverse dans un run binaire 
+static int ecrireRun(NoeudAVL *racine, FILE *run) {
+    if (racine == NULL)
+        return 0;
+    if (ecrireRun(racine->fd, run) != 0 || ecrireBinaire(&racine->usine, run) != 0)
+        return 1;
+    return ecrireRun(racine->fg, run);
+}
+
+/*
+ Fusionne nb runs tries (ordre decroissant) : a chaque etape on prend
+ le plus grand identifiant en tete des runs. Si mode > 0 on ecrit le texte
+ final, sinon on ecrit un nouveau run binaire.
+ */
+static int fusionnerRuns(FILE **runs, int nb, FILE *sortie, int mode) {
+    Usine tetes[NB_PARTITIONS_MAX];
+    int actif[NB_PARTITIONS_MAX];
+    int i, choisi;
+
+    for (i = 0; i < nb; i++) {
+        rewind(runs[i]);
+        actif[i] = (fread(&tetes[i], sizeof(Usine), 1, runs[i]) == 1);
+    }
+
+    while (1) {
+        choisi = -1;
+        for (i = 0; i < nb; i++) {
+            if (actif[i] && (choisi < 0 ||
+                strcmp(tetes[i].identifiant, tetes[choisi].identifiant) > 0)) {
+                choisi = i;
+            }
+        }
+        if (choisi < 0)
+            break;
+
+        if (mode > 0)
+            ecrireUsine(&tetes[choisi], sortie, mode);
+        else if (ecrireBinaire(&tetes[choisi], sortie) != 0)
+            return 1;
+
+        actif[choisi] = (fread(&tetes[choisi], sizeof(Usine), 1, runs[choisi]) == 1);
+    }
+
+    for (i = 0; i < nb; i++) {
+        if (ferror(runs[i])) {
+            fprintf(stderr, "Erreur: lecture d'un fichier temporaire impossible\n");
+            return 1;
+        }
+    }
+    return 0;
+}
+
+// Ajoute un run ; si la liste est pleine, on fusionne d'abord tous les runs en un seul 
+static int ajouterRun(Runs *runs, FILE *run) {
+    FILE *fusion;
+    int i, erreur;
+
+    if (runs->nb == NB_PARTITIONS_MAX) {
+        fusion = creerTemporaire();
+        erreur = fusionnerRuns(runs->fichiers, runs->nb, fusion, 0);
+        for (i = 0; i < runs->nb; i++)
+            fclose(runs->fichiers[i]);
+        runs->fichiers[0] = fusion;
+        runs->nb = 1;
+        if (erreur == 0)
+            erreur = verifierTemporaire(fusion);
+        if (erreur != 0) {
+            fclose(run);
+            return 1;
+        }
+    }
+    runs->fichiers[runs->nb] = run;
+    runs->nb++;
+    return 0;
+}
+
+static int agregerPartition(FILE *partition, long maxUsines, int profondeur, Runs *runs);
+
+// Repartit les enregistrements d'un fichier dans nb sous-partitions puis les agrege 
+static int repartir(FILE *partition, int nb, long maxUsines, int profondeur, Runs *runs) {
+    FILE *sous[NB_SOUS_PARTITIONS];
+    Usine usine;
+    int i, erreur = 0;
+
+    for (i = 0; i < nb; i++)
+        sous[i] = creerTemporaire();
+
+    rewind(partition);
+    while (erreur == 0 && fread(&usine, sizeof(Usine), 1, partition) == 1) {
+        i = (int)(hacherIdentifiant(usine.identifiant, (unsigned long)profondeur) % (unsigned long)nb);
+        erreur = ecrireBinaire(&usine, sous[i]);
+    }
+    for (i = 0; i < nb && erreur == 0; i++)
+        erreur = verifierTemporaire(sous[i]);
+
+    for (i = 0; i < nb; i++) {
+        if (erreur == 0)
+            erreur = agregerPartition(sous[i], maxUsines, profondeur, runs);
+        fclose(sous[i]);
+    }
+    return erreur;
+}
+
+/*
+ Agrege une partition dans un AVL. La racine donne le nombre d'usines
+ distinctes : si on depasse maxUsines, on libere l'AVL et on decoupe la partition.
+ Apres PROFONDEUR_MAX decoupages (beaucoup d'usines de meme hachage, ou
+ budget tres petit), la partition est agregee quand meme : on le signale,
+ car la memoire utilisee depasse alors le budget.
+ */
+static int agregerPartition(FILE *partition, long maxUsines, int profondeur, Runs *runs) {
+    NoeudAVL *racine = NULL;
+    Usine usine;
+    FILE *run;
+    int h, averti = 0;
+
+    rewind(partition);
+    while (fread(&usine, sizeof(Usine), 1, partition) == 1) {
+        h = 0;
+        racine = insererAVL(racine, usine, &h);
+
+        if (tailleAVL(racine) > maxUsines) {
+            if (profondeur < PROFONDEUR_MAX) {
+                libererAVL(racine);
+                return repartir(partition, NB_SOUS_PARTITIONS, maxUsines, profondeur + 1, runs);
+            }
+            if (!averti) {
+                fprintf(stderr, "Attention: partition encore trop grosse apres %d decoupages, "
+                                "le budget memoire sera depasse\n", PROFONDEUR_MAX);
+                averti = 1;
+            }
+        }
+    }
+
+    if (ferror(partition)) {
+        fprintf(stderr, "Erreur: lecture d'un fichier temporaire impossible\n");
+        libererAVL(racine);
+        return 1;
+    }
+    if (racine == NULL)
+        return 0;
+
+    run = creerTemporaire();
+    if (ecrireRun(racine, run) != 0 || verifierTemporaire(run) != 0) {
+        libererAVL(racine);
+        fclose(run);
+        return 1;
+    }
+    libererAVL(racine);
+    return ajouterRun(runs, run);
+}
+
+int traiterHistogrammeExterne(char *fichierEntree, char *fichierSortie, int mode, long budgetMo) {
+    FILE *fIn, *fOut;
+    FILE *partitions[NB_PARTITIONS_MAX];
+    struct stat infos;
+    pid_t pid;
+    char ligne[TAILLE_LIGNE];
+    Usine usine;
+    Runs runs;
+    long taille, maxUsines, nbPartitions;
+    int i, erreur = 0;
+
+    if (mode < 1 || mode > 4) {
+        fprintf(stderr, "Erreur: le mode externe ne gere que max, src, real et all\n");
+        return 1;
+    }
+    if (budgetMo <= 0) {
+        fprintf(stderr, "Erreur: budget memoire invalide\n");
+        return 1;
+    }
+
+    fIn = ouvrirEntree(fichierEntree, &pid);
+    if (fIn == NULL) {
+        fprintf(stderr, "Erreur: impossible d'ouvrir %s\n", fichierEntree);
+        return 1;
+    }
+
+    // Nombre de partitions : pire cas = une usine differente par ligne 
+    maxUsines = budgetMo * 1024L * 1024L / (long)TAILLE_NOEUD_ESTIMEE;
+    if (maxUsines < 1)
+        maxUsines = 1;
+    // Pour un fichier compresse, on estime la taille decompressee ; 
+    // si l'estimation est trop faible, les partitions seront re-decoupees
+    taille = 0;
+    if (stat(fichierEntree, &infos) == 0)
+        taille = (long)infos.st_size;
+    if (pid != 0)
+        taille *= TAUX_COMPRESSION;
+    nbPartitions = 1;
+    if (taille > 0)
+        nbPartitions = taille / TAILLE_LIGNE_MIN / maxUsines + 1;
+    if (nbPartitions > NB_PARTITIONS_MAX)
+        nbPartitions = NB_PARTITIONS_MAX;
+
+    for (i = 0; i < nbPartitions; i++)
+        partitions[i] = creerTemporaire();
+
+    // 1) Repartition des lignes 
+    while (erreur == 0 && fgets(ligne, TAILLE_LIGNE, fIn) != NULL) {
+        if (analyserLigneHisto(ligne, &usine, NULL) == LIGNE_IGNOREE)
+            continue;
+        i = (int)(hacherIdentifiant(usine.identifiant, 0) % (unsigned long)nbPartitions);
+        erreur = ecrireBinaire(&usine, partitions[i]);
+    }
+    if (fermerEntree(fIn, pid) != 0)
+        erreur = 1;
+    for (i = 0; i < nbPartitions && erreur == 0; i++)
+        erreur = verifierTemporaire(partitions[i]);
+
+    // 2) Agregation de chaque partition 
+    runs.nb = 0;
+    for (i = 0; i < nbPartitions; i++) {
+        if (erreur == 0)
+            erreur = agregerPartition(partitions[i], maxUsines, 0, &runs);
+        fclose(partitions[i]);
+    }
+    if (erreur != 0) {
+        for (i = 0; i < runs.nb; i++)
+            fclose(runs.fichiers[i]);
+        return 1;
+    }
+
+    // 3) Fusion des runs dans le fichier final 
+    fOut = fopen(fichierSortie, "w");
+    if (fOut == NULL) {
+        fprintf(stderr, "Erreur:impossible de creer %s\n", fichierSortie);
+        for (i = 0; i < runs.nb; i++)
+            fclose(runs.fichiers[i]);
+        return 1;
+    }
+
+    ecrireEnTeteHisto(fOut, mode);
+    erreur = fusionnerRuns(runs.fichiers, runs.nb, fOut, mode);
+    if (ferror(fOut))
+        erreur = 1;
+    if (fclose(fOut) != 0 && erreur == 0) {
+        fprintf(stderr, "Erreur: ecriture de %s incomplete\n", fichierSortie);
+        erreur = 1;
+    }
+
+    for (i = 0; i < runs.nb; i++)
+        fclose(runs.fichiers[i]);
+    if (erreur != 0)
+        return 1;
+
+    printf("Traitement histogramme (%ld partitions) terminer avec succes\n", nbPartitions);
+    return 0;
+}
@@ -0,0 +1,20 @@
+// Histogramme en memoire externe : pour les fichiers plus gros que la RAM.
+// Les lignes sont reparties par hachage de l'identifiant d'usine dans des
+// fichiers temporaires (partitions), chaque partition est agregee seule avec
+// l'AVL habituel, puis les resultats tries sont fusionnes dans vol_<mode>.dat.
+
+#ifndef EXTERNE_H
+#define EXTERNE_H
+
+// Nombre max de fichiers temporaires ouverts en meme temps 
+#define NB_PARTITIONS_MAX 128
+#define NB_SOUS_PARTITIONS 8
+#define PROFONDEUR_MAX 3
+
+/*
+ Meme resultat que traiterHistogramme (modes 1 a 4) mais la memoire
+ utilisee par les AVL reste sous budgetMo mega-octets.
+ */
+int traiterHistogrammeExterne(char *fichierEntree, char *fichierSortie, int mode, long budgetMo);
+
+#endif
@@ -0,0 +1,309 @@
+/*
+  lecture.c - Decoupage et analyse des lignes du fichier de donnees
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <signal.h>
+#include <sys/wait.h>
+#include "lecture.h"
+#include "pipeline.h"
+
+int decouperLigne(char *ligne, char *col1, char *col2, char *col3, char *col4, char *col5) {
+    col1[0] = '\0';
+    col2[0] = '\0';
+    col3[0] = '\0';
+    col4[0] = '\0';
+    col5[0] = '\0';
+
+    return sscanf(ligne, "%49[^;];%49[^;];%49[^;];%49[^;];%49[^\n]",
+                  col1, col2, col3, col4, col5);
+}
+
+static int estUsine(char *col) {
+    return strstr(col, "Plant") != NULL || strstr(col, "Module") != NULL ||
+           strstr(col, "Unit") != NULL || strstr(col, "Facility") != NULL;
+}
+
+static int estSource(char *col) {
+    return strstr(col, "Source") != NULL || strstr(col, "Well") != NULL ||
+           strstr(col, "Spring") != NULL || strstr(col, "Fountain") != NULL ||
+           strstr(col, "Resurgence") != NULL;
+}
+
+int analyserLigneHisto(char *ligne, Usine *usine, char *source) {
+    Enregistrement e;
+
+    e.nbChamps = decouperLigne(ligne, e.col1, e.col2, e.col3, e.col4, e.col5);
+    return analyserEnregistrementHisto(&e, usine, source);
+}
+
+int analyserEnregistrementHisto(Enregistrement *e, Usine *usine, char *source) {
+    double volumeCapte, pourcentageFuite;
+
+    if (e->nbChamps < 2)
+        return LIGNE_IGNOREE;
+
+    // Ligne d'usine: -;Usine;-;capacite;- 
+    if (strcmp(e->col1, "-") == 0 && strcmp(e->col3, "-") == 0 &&
+        strcmp(e->col5, "-") == 0 && strlen(e->col4) > 0) {
+        if (!estUsine(e->col2))
+            return LIGNE_IGNOREE;
+
+        memset(usine, 0, sizeof(Usine));
+        strncpy(usine->identifiant, e->col2, TAILLE_COLONNE);
+        usine->capacite_max = atof(e->col4);
+        usine->volume_capte = 0.0;
+        usine->volume_traite = 0.0;
+        return LIGNE_USINE;
+    }
+
+    // Ligne de captage: -;Source;Usine;volume;pourcentage 
+    if (strcmp(e->col1, "-") == 0 && strlen(e->col4) > 0 && strcmp(e->col4, "-") != 0 &&
+        strlen(e->col5) > 0 && strcmp(e->col5, "-") != 0) {
+        if (!estSource(e->col2) || !estUsine(e->col3))
+            return LIGNE_IGNOREE;
+
+        volumeCapte = atof(e->col4);
+        pourcentageFuite = atof(e->col5);
+
+        memset(usine, 0, sizeof(Usine));
+        strncpy(usine->identifiant, e->col3, TAILLE_COLONNE);
+        usine->capacite_max = 0.0;
+        usine->volume_capte = volumeCapte;
+        usine->volume_traite = volumeCapte * (1.0 - pourcentageFuite / 100.0);
+
+        if (source != NULL)
+            strcpy(source, e->col2);
+        return LIGNE_CAPTAGE;
+    }
+
+    return LIGNE_IGNOREE;
+}
+
+unsigned long hacherIdentifiant(char *identifiant, unsigned long graine) {
+    unsigned long hash = 2166136261UL ^ graine;
+    while (*identifiant != '\0') {
+        hash ^= (unsigned char)*identifiant;
+        hash *= 16777619UL;
+        identifiant++;
+    }
+    return hash;
+}
+
+int caseIdeale(char *identifiant, int tailleTable) {
+    return (int)(hacherIdentifiant(identifiant, 0) & (unsigned long)(tailleTable - 1));
+}
+
+int chercherCaseTable(int *table, int tailleTable, char *identifiant,
+                      void *elements, size_t tailleElement, size_t decalage) {
+    char *base = (char*)elements + decalage;
+    int masque = tailleTable - 1;
+    int i = caseIdeale(identifiant, tailleTable);
+
+    while (table[i] != CASE_VIDE &&
+           strcmp(base + (size_t)table[i] * tailleElement, identifiant) != 0) {
+        i = (i + 1) & masque;
+    }
+    return i;
+}
+
+/*
+ Une ligne appartient au processus dont la plage contient son premier octet :
+ si on ne commence pas au debut du fichier, on saute la fin de la ligne
+ precedente (elle est traitee par le processus d'avant).
+ */
+int debutDecoupage(FILE *f, Decoupage *decoupage, long *position) {
+    int c;
+
+    *position = 0;
+    if (decoupage->debut <= 0)
+        return 0;
+
+    if (fseek(f, decoupage->debut - 1, SEEK_SET) != 0)
+        return 1;
+    *position = decoupage->debut - 1;
+
+    c = fgetc(f);
+    while (c != EOF) {
+        (*position)++;
+        if (c == '\n')
+            break;
+        c = fgetc(f);
+    }
+    return 0;
+}
+
+int lireLigneDecoupage(char *ligne, FILE *f, Decoupage *decoupage, long *position) {
+    if (decoupage->fin >= 0 && *position >= decoupage->fin)
+        return 0;
+    if (fgets(ligne, TAILLE_LIGNE, f) == NULL)
+        return 0;
+    *position += (long)strlen(ligne);
+    return 1;
+}
+
+int dansShard(Usine *usine, Decoupage *decoupage) {
+    if (decoupage->nbShards <= 0)
+        return 1;
+    return (int)(hacherIdentifiant(usine->identifiant, 0) % (unsigned long)decoupage->nbShards)
+           == decoupage->shard;
+}
+
+//      Fichiers compresses 
+
+// Signatures (magic bytes) des formats reconnus 
+static const unsigned char SIGNATURE_GZIP[2] = {0x1f, 0x8b};
+static const unsigned char SIGNATURE_ZSTD[4] = {0x28, 0xb5, 0x2f, 0xfd};
+
+// Renvoie l'outil de decompression a utiliser, NULL si le fichier n'est pas compresse 
+static const char* detecterCompression(FILE *f) {
+    unsigned char debut[4];
+    size_t n = fread(debut, 1, sizeof(debut), f);
+
+    rewind(f);
+    if (n >= 2 && memcmp(debut, SIGNATURE_GZIP, 2) == 0)
+        return "gzip";
+    if (n >= 4 && memcmp(debut, SIGNATURE_ZSTD, 4) == 0)
+        return "zstd";
+    return NULL;
+}
+
+FILE* ouvrirEntree(char *fichier, pid_t *pid) {
+    FILE *f;
+    const char *outil;
+    int tube[2];
+
+    *pid = 0;
+    f = fopen(fichier, "r");
+    if (f == NULL)
+        return NULL;
+
+    outil = detecterCompression(f);
+    if (outil == NULL)
+        return f;
+    fclose(f);
+
+    if (pipe(tube) != 0)
+        return NULL;
+
+    *pid = fork();
+    if (*pid < 0) {
+        close(tube[0]);
+        close(tube[1]);
+        *pid = 0;
+        return NULL;
+    }
+
+    if (*pid == 0) {
+        // Processus fils : sa sortie standard devient l'entree du tube 
+        close(tube[0]);
+        dup2(tube[1], STDOUT_FILENO);
+        close(tube[1]);
+        execlp(outil, outil, "-dc", "--", fichier, (char*)NULL);
+        fprintf(stderr, "Erreur: impossible de lancer %s\n", outil);
+        _exit(127);
+    }
+
+    close(tube[1]);
+    f = fdopen(tube[0], "r");
+    if (f == NULL) {
+        close(tube[0]);
+        waitpid(*pid, NULL, 0);
+        *pid = 0;
+    }
+    return f;
+}
+
+int fermerEntree(FILE *f, pid_t pid) {
+    int statut;
+    int arrete = !feof(f) && !ferror(f);
+
+    fclose(f);
+    if (pid == 0)
+        return 0;
+
+    if (waitpid(pid, &statut, 0) != pid) {
+        fprintf(stderr, "Erreur: la decompression du fichier d'entree a echoue\n");
+        return 1;
+    }
+    // Lecture arretee volontairement avant la fin : le fils ecrit dans un tube ferme 
+    if (arrete && WIFSIGNALED(statut) && WTERMSIG(statut) == SIGPIPE)
+        return 0;
+    if (!WIFEXITED(statut) || WEXITSTATUS(statut) != 0) {
+        fprintf(stderr, "Erreur: la decompression du fichier d'entree a echoue\n");
+        return 1;
+    }
+    return 0;
+}
+
+//      Lecteur 
+
+int ouvrirLecteur(Lecteur *lecteur, FILE *f, Decoupage *decoupage, int pipeline) {
+    lecteur->f = f;
+    lecteur->decoupage = decoupage;
+    lecteur->position = 0;
+    lecteur->pipeline = NULL;
+    lecteur->lot = NULL;
+    lecteur->indice = 0;
+    lecteur->termine = 0;
+
+    if (decoupage != NULL && debutDecoupage(f, decoupage, &lecteur->position) != 0)
+        return 1;
+
+    if (pipeline) {
+        lecteur->pipeline = demarrerPipeline(f, lecteur->position,
+                                             decoupage != NULL ? decoupage->fin : -1);
+    }
+    return 0;
+}
+
+Enregistrement* lireEnregistrement(Lecteur *lecteur) {
+    Enregistrement *e;
+
+    if (lecteur->termine)
+        return NULL;
+
+    // Lecture directe 
+    if (lecteur->pipeline == NULL) {
+        if (lecteur->decoupage != NULL) {
+            if (!lireLigneDecoupage(lecteur->ligne, lecteur->f, lecteur->decoupage, &lecteur->position)) {
+                lecteur->termine = 1;
+                return NULL;
+            }
+        } else if (fgets(lecteur->ligne, TAILLE_LIGNE, lecteur->f) == NULL) {
+            lecteur->termine = 1;
+            return NULL;
+        }
+        e = &lecteur->courant;
+        e->nbChamps = decouperLigne(lecteur->ligne, e->col1, e->col2, e->col3, e->col4, e->col5);
+        return e;
+    }
+
+    // Pipeline : on passe au lot suivant quand le lot courant est fini 
+    while (lecteur->lot == NULL || lecteur->indice >= lecteur->lot->nb) {
+        if (lecteur->lot != NULL)
+            rendreLot(lecteur->pipeline, lecteur->lot);
+        lecteur->lot = lotSuivant(lecteur->pipeline);
+        lecteur->indice = 0;
+        if (lecteur->lot == NULL) {
+            lecteur->termine = 1;
+            return NULL;
+        }
+    }
+    e = &lecteur->lot->e[lecteur->indice];
+    lecteur->indice++;
+    return e;
+}
+
+void fermerLecteur(Lecteur *lecteur) {
+    if (lecteur->pipeline == NULL)
+        return;
+    if (lecteur->lot != NULL)
+        rendreLot(lecteur->pipeline, lecteur->lot);
+    arreterPipeline(lecteur->pipeline, lecteur->termine);
+    lecteur->pipeline = NULL;
+    lecteur->lot = NULL;
+}
@@ -0,0 +1,120 @@
+// Lecture et decoupage des lignes du fichier de donnees.
+// Regroupe l'analyse des lignes commune a plusieurs traitements
+// (histogramme en memoire, histogramme externe, ...).
+
+#ifndef LECTURE_H
+#define LECTURE_H
+
+#include <stdio.h>
+#include <sys/types.h>
+#include "avl.h"
+
+#define TAILLE_LIGNE 256
+#define TAILLE_COLONNE 50
+
+// Type de ligne pour l'histogramme 
+#define LIGNE_IGNOREE 0
+#define LIGNE_USINE 1
+#define LIGNE_CAPTAGE 2
+
+// Ligne decoupee en colonnes 
+typedef struct enregistrement {
+    int nbChamps;
+    char col1[TAILLE_COLONNE];
+    char col2[TAILLE_COLONNE];
+    char col3[TAILLE_COLONNE];
+    char col4[TAILLE_COLONNE];
+    char col5[TAILLE_COLONNE];
+} Enregistrement;
+
+/*
+ Partie du fichier traitee par un processus (travail reparti) :
+ - les lignes qui commencent dans [debut, fin[ (fin = -1 : jusqu'a la fin)
+ - les usines dont hachage(identifiant) % nbShards == shard (nbShards = 0 : toutes)
+ */
+typedef struct decoupage {
+    long debut;
+    long fin;
+    int shard;
+    int nbShards;
+} Decoupage;
+
+/*
+ Ouvre un fichier d'entree. Si ses premiers octets sont ceux d'un fichier
+ gzip ou zstd, on lance "gzip -dc" ou "zstd -dc" dans un processus fils et
+ on lit sa sortie : la decompression se fait en parallele de l'analyse,
+ sans fichier decompresse sur le disque. pid recoit le fils (0 sinon).
+ Un flux decompresse ne permet pas fseek (pas de --bytes).
+ */
+FILE* ouvrirEntree(char *fichier, pid_t *pid);
+
+// Ferme le fichier et attend le fils ; renvoie 1 si la decompression a echoue.
+// Si la lecture s'est arretee avant la fin, un fils tue par SIGPIPE n'est pas une erreur. 
+int fermerEntree(FILE *f, pid_t pid);
+
+/*
+ Lecteur d'enregistrements : lecture directe (fgets + sscanf) ou
+ pipeline sur plusieurs threads, au choix, avec la meme interface.
+ */
+struct pipeline;
+struct lotEnregistrements;
+
+typedef struct lecteur {
+    FILE *f;
+    Decoupage *decoupage;           // NULL = tout le fichier
+    long position;
+    struct pipeline *pipeline;      // NULL = lecture directe
+    struct lotEnregistrements *lot;
+    int indice;
+    int termine;
+    char ligne[TAILLE_LIGNE];
+    Enregistrement courant;
+} Lecteur;
+
+// Decoupe une ligne en 5 colonnes separees par ';', renvoie le nombre de champs lus 
+int decouperLigne(char *ligne, char *col1, char *col2, char *col3, char *col4, char *col5);
+
+/*
+  Analyse une ligne pour l'histogramme et remplit usine :
+  - ligne d'usine   (-;Usine;-;capacite;-)          -> LIGNE_USINE
+  - ligne de captage (-;Source;Usine;volume;fuite)  -> LIGNE_CAPTAGE
+  source (peut etre NULL) recoit l'identifiant de la source d'un captage.
+ */
+int analyserLigneHisto(char *ligne, Usine *usine, char *source);
+int analyserEnregistrementHisto(Enregistrement *e, Usine *usine, char *source);
+
+// Prepare la lecture de f (deja ouvert), avec ou sans pipeline 
+int ouvrirLecteur(Lecteur *lecteur, FILE *f, Decoupage *decoupage, int pipeline);
+
+// Enregistrement suivant, NULL a la fin 
+Enregistrement* lireEnregistrement(Lecteur *lecteur);
+
+// Arrete le pipeline s'il y en a un (ne ferme pas le fichier) 
+void fermerLecteur(Lecteur *lecteur);
+
+// Hachage FNV-1a d'un identifiant (graine pour obtenir plusieurs fonctions) 
+unsigned long hacherIdentifiant(char *identifiant, unsigned long graine);
+
+/*
+ Table de hachage a adressage ouvert (sondage lineaire) : chaque case
+ contient CASE_VIDE ou l'indice d'un element dans un tableau de l'appelant.
+ Un element fait tailleElement octets, son identifiant commence a decalage.
+ tailleTable est une puissance de 2 ; la case ideale d'un identifiant est
+ caseIdeale(identifiant, tailleTable).
+ Renvoie la case de identifiant, ou la case vide ou l'inserer.
+ */
+#define CASE_VIDE -1
+int caseIdeale(char *identifiant, int tailleTable);
+int chercherCaseTable(int *table, int tailleTable, char *identifiant,
+                      void *elements, size_t tailleElement, size_t decalage);
+
+// Se place sur la premiere ligne complete a partir de decoupage->debut 
+int debutDecoupage(FILE *f, Decoupage *decoupage, long *position);
+
+// Lit la ligne suivante si elle commence avant decoupage->fin, renvoie 0 sinon 
+int lireLigneDecoupage(char *ligne, FILE *f, Decoupage *decoupage, long *position);
+
+// 1 si l'usine appartient au shard de ce processus 
+int dansShard(Usine *usine, Decoupage *decoupage);
+
+#endif
@@ -1,7 +1,7 @@
 /*
  * ce programme peut generer des histogrammes ou calculer les fuites d'une usine.
  * leaks " id"
- * Modes pour histo: max, src, real
+ * Modes pour histo: max, src, real, all, contrib
  */
 
 #include <stdio.h>
@@ -9,112 +9,212 @@
 #include <string.h>
 #include "avl.h"
 #include "arbre_distrib.h"
-
-#define TAILLE_LIGNE 256
+#include "contrib.h"
+#include "lecture.h"
+#include "externe.h"
+#include "partiel.h"
+#include "stats.h"
+#include "cache.h"
+#include "apercu.h"
+#include "validation.h"
+#include "construction.h"
+#include "difference.h"
+
+// Tampon d'ecriture du detail par noeud (--export) 
+#define TAILLE_TAMPON_EXPORT (1 << 20)
 
 /* 
  * Traitement histogramme: lit le fichier filtrer par le   Shell,
  * construit un AVL des usines en cumulant les volumes captes et traites,
  * Mode: 1=capacite max, 2=volume capte, 3=volume traite, 4=les trois
- * mode: 1=max, 2=src, 3=real, 4=all
+ * mode: 1=max, 2=src, 3=real, 4=all, 5=contrib
+ * En mode contrib on garde en plus un AVL (usine, source) pour la matrice
+ * de contribution, rempli pendant la meme lecture.
+ * decoupage: partie du fichier (plage d'octets, shard d'usines) a traiter
+ * partiel: si 1, on ecrit un fichier partiel binaire au lieu de vol_<mode>.dat
+ * pipeline: si 1, lecture et decoupage des lignes sur deux threads a part
+ * intervalle: si non NULL, seules les usines de cet intervalle (ou prefixe) sont ecrites
  */
-int traiterHistogramme(char *fichierEntree, char *fichierSortie, int mode) {
+int traiterHistogramme(char *fichierEntree, char *fichierSortie, int mode,
+                       Decoupage *decoupage, int partiel, int pipeline,
+                       Intervalle *intervalle) {
     FILE *fIn, *fOut;
-    char ligne[TAILLE_LIGNE];
-    char col1[50], col2[50], col3[50], col4[50], col5[50];
+    pid_t pid;
+    Lecteur lecteur;
+    Enregistrement *e;
+    char source[TAILLE_COLONNE];
     NoeudAVL *racine = NULL;
+    NoeudContrib *racineContrib = NULL;
     Usine usine;
-    int nbChamps;
+    Contribution contrib;
+    int typeLigne;
     int h;
-    double volumeCapte, pourcentageFuite;
 
     
-    fIn = fopen(fichierEntree, "r");
+    fIn = ouvrirEntree(fichierEntree, &pid);
     if (fIn == NULL) {
         fprintf(stderr, "Erreur: impossible d'ouvrir %s\n", fichierEntree);
         return 1;
     }
 
-    
-    while (fgets(ligne, TAILLE_LIGNE, fIn) != NULL) {
-        col1[0] = '\0';
-        col2[0] = '\0';
-        col3[0] = '\0';
-        col4[0] = '\0';
-        col5[0] = '\0';
+    // Un flux decompresse ne se positionne pas : pas de plage d'octets 
+    if (pid != 0 && (decoupage->debut > 0 || decoupage->fin >= 0)) {
+        fprintf(stderr, "Erreur: --bytes n'est pas possible sur un fichier compresse (%s)\n", fichierEntree);
+        fermerEntree(fIn, pid);
+        return 1;
+    }
 
-        nbChamps = sscanf(ligne, "%49[^;];%49[^;];%49[^;];%49[^;];%49[^\n]",
-                          col1, col2, col3, col4, col5);
+    if (ouvrirLecteur(&lecteur, fIn, decoupage, pipeline) != 0) {
+        fprintf(stderr, "Erreur: position %ld invalide dans %s\n", decoupage->debut, fichierEntree);
+        fermerEntree(fIn, pid);
+        return 1;
+    }
 
-        if (nbChamps < 2)
+    while ((e = lireEnregistrement(&lecteur)) != NULL) {
+        typeLigne = analyserEnregistrementHisto(e, &usine, source);
+        if (typeLigne == LIGNE_IGNOREE || !dansShard(&usine, decoupage))
             continue;
 
-        // Ligne d'usine: -;Usine;-;capacite;- 
-        if (strcmp(col1, "-") == 0 && strcmp(col3, "-") == 0 && 
-            strcmp(col5, "-") == 0 && strlen(col4) > 0) {
-            if (strstr(col2, "Plant") != NULL || strstr(col2, "Module") != NULL ||
-                strstr(col2, "Unit") != NULL || strstr(col2, "Facility") != NULL) {
-                memset(&usine, 0, sizeof(Usine));
-                strncpy(usine.identifiant, col2, 49);
-                usine.identifiant[49] = '\0';
-                usine.capacite_max = atof(col4);
-                usine.volume_capte = 0.0;
-                usine.volume_traite = 0.0;
-                h = 0;
-                racine = insererAVL(racine, usine, &h);
-            }
-        }
-        // Ligne de captage: -;Source;Usine;volume;pourcentage 
-        else if (strcmp(col1, "-") == 0 && strlen(col4) > 0 && strcmp(col4, "-") != 0 &&
-                 strlen(col5) > 0 && strcmp(col5, "-") != 0) {
-            if ((strstr(col2, "Source") != NULL || strstr(col2, "Well") != NULL ||
-                 strstr(col2, "Spring") != NULL || strstr(col2, "Fountain") != NULL ||
-                 strstr(col2, "Resurgence") != NULL) &&
-                (strstr(col3, "Plant") != NULL || strstr(col3, "Module") != NULL ||
-                 strstr(col3, "Unit") != NULL || strstr(col3, "Facility") != NULL)) {
-                
-                volumeCapte = atof(col4);
-                pourcentageFuite = atof(col5);
-
-                memset(&usine, 0, sizeof(Usine));
-                strncpy(usine.identifiant, col3, 49);
-                usine.identifiant[49] = '\0';
-                usine.capacite_max = 0.0;
-                usine.volume_capte = volumeCapte;
-                usine.volume_traite = volumeCapte * (1.0 - pourcentageFuite / 100.0);
-                
-                h = 0;
-                racine = insererAVL(racine, usine, &h);
-            }
+        h = 0;
+        racine = insererAVL(racine, usine, &h);
+
+        if (mode == 5 && typeLigne == LIGNE_CAPTAGE) {
+            strcpy(contrib.usine, usine.identifiant);
+            strcpy(contrib.source, source);
+            contrib.volume_capte = usine.volume_capte;
+            contrib.volume_traite = usine.volume_traite;
+            h = 0;
+            racineContrib = insererContrib(racineContrib, contrib, &h);
         }
     }
 
-    fclose(fIn);
+    fermerLecteur(&lecteur);
+    if (fermerEntree(fIn, pid) != 0) {
+        libererAVL(racine);
+        libererContrib(racineContrib);
+        return 1;
+    }
+
+    if (partiel) {
+        h = ecrirePartiel(racine, fichierSortie);
+        libererAVL(racine);
+        return h;
+    }
 
     
     fOut = fopen(fichierSortie, "w");
     if (fOut == NULL) {
         fprintf(stderr, "Erreur:impossible de creer %s\n", fichierSortie);
         libererAVL(racine);
+        libererContrib(racineContrib);
         return 1 ;
     }
 
     /* ecrire l'en-tete */
-    if (mode == 1) {
-        fprintf(fOut, "identifier;max volume(M.m3.year-1)\n");
-    } else if (mode == 2) {
-        fprintf(fOut, "identifier;source volume (M.m3.year-1)\n");
-    } else if (mode == 3) {
-        fprintf(fOut, "identifier;real volume (M.m3.year-1)\n");
-    } else if (mode == 4) {
-        fprintf(fOut, "identifier;real volume;lost volume;available capacity\n");
+    if (mode == 5) {
+        fprintf(fOut, "identifier;source;source volume;real volume;lost volume;share of real volume(%%)\n");
+    } else {
+        ecrireEnTeteHisto(fOut, mode);
     }
 
-    parcoursInverseAVL(racine, fOut, mode);
+    if (mode == 5) {
+        parcoursInverseContrib(racineContrib, racine, fOut);
+    } else if (intervalle != NULL) {
+        parcoursInverseIntervalleAVL(racine, intervalle, fOut, mode);
+    } else {
+        parcoursInverseAVL(racine, fOut, mode);
+    }
 
     fclose(fOut);
     printf("Traitement histogramme terminer avec succes\n");
     libererAVL(racine );
+    libererContrib(racineContrib);
+    return 0;
+}
+
+// Tous les noeuds crees sont dans l'arbre de l'usine : l'arbre puis son index 
+static void libererFuites(Arbre *racineArbre, AVL_Index *racineIndex) {
+    libererArbre(racineArbre);
+    libererAVLIndex(racineIndex);
+}
+
+// Calcul des fuites en ecrivant le detail par noeud (tampon de grande taille) 
+static int exporterFuites(char *fichierExport, Arbre *racineArbre, double volume_initial,
+                          double *fuites_totales) {
+    FILE *fExport;
+    char *tampon;
+
+    fExport = fopen(fichierExport, "w");
+    if (fExport == NULL) {
+        fprintf(stderr, "Erreur:impossible de creer %s\n", fichierExport);
+        return 1;
+    }
+    tampon = (char*)malloc(TAILLE_TAMPON_EXPORT);
+    if (tampon != NULL)
+        setvbuf(fExport, tampon, _IOFBF, TAILLE_TAMPON_EXPORT);
+
+    fprintf(fExport, "node;parent;inflow (M.m3);loss (M.m3)\n");
+    *fuites_totales = calculerFuitesExport(racineArbre, volume_initial, fExport);
+
+    if (fclose(fExport) != 0) {
+        fprintf(stderr, "Erreur: ecriture de %s incomplete\n", fichierExport);
+        free(tampon);
+        return 1;
+    }
+    free(tampon);
+    return 0;
+}
+
+// Calcul et ecriture des fuites une fois l'arbre construit 
+static int terminerFuites(char *fichierSortie, char *idUsine, Arbre *racineArbre,
+                          AVL_Index *racineIndex, double volume_initial, int usine_trouvee,
+                          char *fichierExport, double *resultat) {
+    FILE *fOut;
+    double fuites_totales = 0.0;
+
+    /* Si n existe pas , ecrire -1 */
+    if (!usine_trouvee) {
+        libererFuites(racineArbre, racineIndex);
+        fOut = fopen(fichierSortie, "a");
+        if (fOut == NULL) {
+            fprintf(stderr, "Erreur: impossible d'ouvrir %s\n", fichierSortie);
+            return 1;
+        }
+        fprintf(fOut, "%s;-1\n", idUsine);
+        fclose(fOut);
+        if (resultat != NULL)
+            *resultat = -1.0;
+        return 0;
+    }
+
+    //   Calculer les fuites 
+    if (fichierExport == NULL) {
+        fuites_totales = calculerFuites(racineArbre, volume_initial);
+    } else if (exporterFuites(fichierExport, racineArbre, volume_initial, &fuites_totales) != 0) {
+        libererFuites(racineArbre, racineIndex);
+        return 1;
+    }
+
+    
+    fuites_totales = fuites_totales /1000.0;
+
+    /*Ecrire le resultat */
+    fOut = fopen(fichierSortie, "a");
+    if (fOut == NULL) {
+        fprintf(stderr, "Erreur: impossible d'ouvrir %s \n", fichierSortie);
+        libererFuites(racineArbre, racineIndex);
+        return 1;
+    }
+
+    fprintf(fOut, "%s;%.6f\n", idUsine, fuites_totales);
+    fclose(fOut) ;
+
+    /* Liberer la memoire*/
+    libererFuites(racineArbre, racineIndex);
+
+    printf("Fuites calculer pour %s: %.6f M.m3\n", idUsine, fuites_totales);
+    if (resultat != NULL)
+        *resultat = fuites_totales;
     return 0;
 }
 
@@ -125,17 +225,25 @@ int traiterHistogramme(char *fichierEntree, char *fichierSortie, int mode) {
  * aval de l'usine,puis calcule recursivement les pertes d'eau
  * - Un AVLIndex pour retrouver rapidement les noeuds par leurs nom
 * puis ajouter enfants
+ * Le volume initial et l'arbre sont calcules pendant la meme lecture du fichier.
+ * Une arete dont le parent n'est pas encore dans l'arbre est ignoree ; un
+ * enfant deja vu recoit une nouvelle copie, et l'index pointe sur la derniere.
+ * La construction sur plusieurs threads relie les aretes avec la meme regle.
+ * pipeline: si 1, lecture et decoupage des lignes sur deux threads a part
+ * nbThreads: si > 1, l'arbre est construit par plusieurs threads (construction.c)
+ * fichierExport: si non NULL, recoit le volume recu et la perte de chaque noeud
+ * resultat: si non NULL, recoit les fuites ecrites (-1 si l'usine n'existe pas)
  */
-int traiterFuites(char *fichierEntree, char *fichierSortie, char *idUsine) {
-    FILE *fIn, *fOut;
-    char ligne[TAILLE_LIGNE];
-    char col1[50], col2[50], col3[50], col4[50], col5[50];
-    int nbChamps;
+int traiterFuites(char *fichierEntree, char *fichierSortie, char *idUsine, int pipeline,
+                  int nbThreads, char *fichierExport, double *resultat) {
+    FILE *fIn;
+    pid_t pid;
+    Lecteur lecteur;
+    Enregistrement *e;
     int usine_trouvee = 0;
     int h;
-    float volume_initial = 0.0f;
-    float fuites_totales = 0.0f;
-    float pourcentage;
+    double volume_initial = 0.0;
+    double pourcentage;
 
     /* Arbre de distribution et AVL d'index */
     Arbre *racineArbre = NULL;
@@ -143,141 +251,176 @@ int traiterFuites(char *fichierEntree, char *fichierSortie, char *idUsine) {
     Arbre *parent, *nouveau;
 
     /* Ouvrir le fichier d'entree */
-    fIn = fopen(fichierEntree, "r");
+    fIn = ouvrirEntree(fichierEntree, &pid);
     if (fIn == NULL) {
         fprintf(stderr, "Erreur: impossible d'ouvrir %s\n", fichierEntree);
         return 1;
     }
 
-    /*1) calculer le volume initial  */
-    /* On cherche les lignes source -> usine pour notre usine */
-    while (fgets(ligne, TAILLE_LIGNE, fIn) != NULL) {
-        col1[0] = '\0';
-        col2[0] = '\0';
-        col3[0] = '\0';
-        col4[0] = '\0';
-        col5[0] = '\0';
-
-        nbChamps = sscanf(ligne, "%49[^;];%49[^;];%49[^;];%49[^;];%49[^\n]",
-                          col1, col2, col3, col4, col5);
-
-        if (nbChamps < 2)
-            continue;
-
-        /* Ligne source ->usine: -;Source;Usine;volume;pourcentage */
-        if (strcmp(col1, "-") == 0 && strcmp(col3, idUsine) == 0 &&
-            strlen(col4) > 0 && strcmp(col4, "-") != 0 &&
-            strlen(col5) > 0 && strcmp(col5, "-") != 0) {
-            float vol = (float)atof(col4);
-            float fuite = (float)atof(col5);
-            volume_initial += vol * (1.0f - fuite / 100.0f);
-            usine_trouvee = 1;
-        }
-    }
-
-    /* Si n existe pas , ecrire -1 */
-    if (!usine_trouvee) {
+    // Fichier compresse : pas de plages d'octets, on reste sur un seul thread 
+    if (nbThreads > 1 && pid == 0) {
         fclose(fIn);
-        fOut = fopen(fichierSortie, "a");
-        if (fOut == NULL) {
-            fprintf(stderr, "Erreur: impossible d'ouvrir %s\n", fichierSortie);
+        racineArbre = construireArbreParallele(fichierEntree, idUsine, nbThreads, &racineIndex,
+                                               &volume_initial, &usine_trouvee);
+        if (racineArbre == NULL)
             return 1;
-        }
-        fprintf(fOut, "%s;-1\n", idUsine);
-        fclose(fOut);
-        return 0;
+        return terminerFuites(fichierSortie, idUsine, racineArbre, racineIndex,
+                              volume_initial, usine_trouvee, fichierExport, resultat);
+    }
+    if (ouvrirLecteur(&lecteur, fIn, NULL, pipeline) != 0) {
+        fprintf(stderr, "Erreur: lecture de %s impossible\n", fichierEntree);
+        fermerEntree(fIn, pid);
+        return 1;
     }
-
-    /* 2) construire l'arbre de distribution  */
-    rewind(fIn);
 
     //Creer le noeud racine (l'usine elle-meme) 
-    racineArbre = creerArbre(idUsine, 0.0f);
+    racineArbre = creerArbre(idUsine, 0.0);
     h = 0;
     racineIndex = insererAVLIndex(racineIndex, idUsine, racineArbre, &h);
 
-    while (fgets(ligne, TAILLE_LIGNE, fIn) != NULL) {
-        col1[0] = '\0';
-        col2[0]= '\0';
-        col3[0]= '\0';
-        col4[0]= '\0';
-        col5[0]= '\0';
+    while ((e = lireEnregistrement(&lecteur)) != NULL) {
+        if (e->nbChamps < 2)
+            continue;
 
-        nbChamps = sscanf(ligne, "%49[^;];%49[^;];%49[^;];%49[^;];%49[^\n]",
-                          col1, col2, col3, col4, col5);
+        /*1) calculer le volume initial  */
+        /* Ligne source ->usine: -;Source;Usine;volume;pourcentage */
+        if (strcmp(e->col1, "-") == 0 && strcmp(e->col3, idUsine) == 0 &&
+            strlen(e->col4) > 0 && strcmp(e->col4, "-") != 0 &&
+            strlen(e->col5) > 0 && strcmp(e->col5, "-") != 0) {
+            double vol = atof(e->col4);
+            double fuite = atof(e->col5);
+            volume_initial += vol * (1.0 - fuite / 100.0);
+            usine_trouvee = 1;
+        }
 
-        if (nbChamps < 3)
+        if (e->nbChamps < 3)
             continue;
 
+        /* 2) construire l'arbre de distribution  */
         /* 
            *Verifier si cette ligne concerne notre usine:
          * - col1 contient l'usine (pour distribution)
          * -OU bien col1 = "-" et col2 = usine (pour usine-> stockage)
          */
-        if ((strcmp(col1, idUsine) == 0) || 
-            (strcmp(col1, "-") == 0 && strcmp(col2, idUsine) == 0)) {
+        if ((strcmp(e->col1, idUsine) == 0) || 
+            (strcmp(e->col1, "-") == 0 && strcmp(e->col2, idUsine) == 0)) {
             
             /* Recuperer le pourcentage de fuite */
-            if (strlen(col5) > 0 && strcmp(col5, "-") != 0) {
-                pourcentage = (float)atof(col5);
+            if (strlen(e->col5) > 0 && strcmp(e->col5, "-") != 0) {
+                pourcentage = atof(e->col5);
             } else {
-                pourcentage = 0.0f;
+                pourcentage = 0.0;
             }
 
             //Chercher le parent dans l'AVL d'index 
-            parent = rechercherAVLIndex(racineIndex, col2);
+            parent = rechercherAVLIndex(racineIndex, e->col2);
             
-            if (parent != NULL && strlen(col3) > 0 && strcmp(col3, "-") != 0) {
+            if (parent != NULL && strlen(e->col3) > 0 && strcmp(e->col3, "-") != 0) {
                 
-                nouveau = creerArbre(col3, pourcentage);
+                nouveau = creerArbre(e->col3, pourcentage);
                 
            
                 ajouterEnfant(parent, nouveau);
                 
                 /* Ajouter au AVL d'index pour pouvoir le retrouver */
                 h = 0;
-                racineIndex =insererAVLIndex(racineIndex, col3, nouveau, &h);
+                racineIndex =insererAVLIndex(racineIndex, e->col3, nouveau, &h);
             }
         }
     }
 
-    fclose(fIn );
-
-    //   Calculer les fuites 
-    fuites_totales = calculerFuites(racineArbre, volume_initial);
+    fermerLecteur(&lecteur);
+    if (fermerEntree(fIn, pid) != 0) {
+        libererFuites(racineArbre, racineIndex);
+        return 1;
+    }
 
-    
-    fuites_totales = fuites_totales /1000.0f;
+    return terminerFuites(fichierSortie, idUsine, racineArbre, racineIndex,
+                          volume_initial, usine_trouvee, fichierExport, resultat);
+}
 
-    /*Ecrire le resultat */
-    fOut = fopen(fichierSortie, "a");
-    if (fOut == NULL) {
-        fprintf(stderr, "Erreur: impossible d'ouvrir %s \n", fichierSortie);
-        libererArbre(racineArbre);
-        libererAVLIndex(racineIndex);
+/*
+ Fuites avec cache : la cle est l'empreinte de fichierCle (le fichier de
+ donnees d'origine, qui peut differer du fichier filtre lu) et l'usine.
+ En cas de succes on ecrit directement la ligne du cache.
+ modeCache: CACHE_LECTURE_SEULE ne calcule pas en cas d'echec (code de retour 3),
+ CACHE_ECRITURE_SEULE ne cherche pas (le script vient de faire la recherche :
+ la compter une seconde fois fausserait le nombre d'echecs).
+ */
+int traiterFuitesCache(char *fichierEntree, char *fichierSortie, char *idUsine, int pipeline,
+                       int nbThreads, char *fichierCache, int capacite, char *fichierCle, int modeCache) {
+    Empreinte empreinte;
+    StatsCache stats;
+    FILE *fOut;
+    double fuites;
+    int trouve, retour;
+
+    if (calculerEmpreinte(fichierCle, &empreinte) != 0) {
+        fprintf(stderr, "Erreur: impossible d'ouvrir %s\n", fichierCle);
         return 1;
     }
 
-    fprintf(fOut, "%s;%.6f\n", idUsine, fuites_totales);
-    fclose(fOut) ;
+    trouve = 0;
+    if (modeCache != CACHE_ECRITURE_SEULE) {
+        trouve = chercherCache(fichierCache, &empreinte, idUsine, &fuites, &stats);
+        printf("Cache %s: %s (%llu succes, %llu echecs, %d entrees)\n", fichierCache,
+               trouve ? "trouve" : "absent", stats.succes, stats.echecs, stats.nbEntrees);
+    }
 
-    /* Liberer la memoire*/
-    libererArbre(racineArbre);
-    libererAVLIndex(racineIndex );
+    if (trouve) {
+        fOut = fopen(fichierSortie, "a");
+        if (fOut == NULL) {
+            fprintf(stderr, "Erreur: impossible d'ouvrir %s\n", fichierSortie);
+            return 1;
+        }
+        if (fuites < 0) {
+            fprintf(fOut, "%s;-1\n", idUsine);
+        } else {
+            fprintf(fOut, "%s;%.6f\n", idUsine, fuites);
+            printf("Fuites calculer pour %s: %.6f M.m3\n", idUsine, fuites);
+        }
+        fclose(fOut);
+        return 0;
+    }
 
-    printf("Fuites calculer pour %s: %.6f M.m3\n", idUsine, fuites_totales);
-    return 0;
+    if (modeCache == CACHE_LECTURE_SEULE)
+        return 3;
+
+    retour = traiterFuites(fichierEntree, fichierSortie, idUsine, pipeline, nbThreads, NULL, &fuites);
+    if (retour == 0)
+        ajouterCache(fichierCache, &empreinte, idUsine, fuites, capacite);
+    return retour;
 }
 
 // Fonction principale : analyse des arguments
 int main(int argc, char *argv[]) {
     int mode;
+    int i;
+    long budgetMo = 0;
+    int partiel = 0;
+    int pipeline = 0;
+    Intervalle intervalle;
+    Intervalle *filtre = NULL;
+    Decoupage decoupage = {0, -1, 0, 0};
 
     if (argc < 5 ) {
         fprintf(stderr, "Usage:\n");
-        fprintf(stderr, "  %s histo <mode> <fichier_entree> <fichier_sortie>\n", argv[0]);
-        fprintf(stderr, "  %s leaks <id_usine> <fichier_entree> <fichier_sortie>\n", argv[0]);
-        fprintf(stderr, "Modes: max, src, real, all \n");
+        fprintf(stderr, "  %s histo <mode> <fichier_entree> <fichier_sortie> [--memory <Mo>]\n", argv[0]);
+        fprintf(stderr, "        [--partial] [--shard <k>/<n>] [--bytes <debut>:<fin>] [--pipeline]\n");
+        fprintf(stderr, "        [--prefix <prefixe> | --range <id_debut> <id_fin>]\n");
+        fprintf(stderr, "  %s merge <mode|partial> <fichier_sortie> <partiel> [partiel ...]\n", argv[0]);
+        fprintf(stderr, "  %s stats <max|src|real|lost> <fichier_entree> <fichier_sortie>\n", argv[0]);
+        fprintf(stderr, "        [--rank <id_usine>]... [--position <id_usine>]... [--range-sum <debut> <fin>]\n");
+        fprintf(stderr, "        [--above <percentile>]\n");
+        fprintf(stderr, "  %s preview <src|real> <fichier_entree> <fichier_sortie>\n", argv[0]);
+        fprintf(stderr, "        [--top <k>] [--memory-kb <Ko>] [--sample <fraction>]\n");
+        fprintf(stderr, "        (--sample sur .gz/.zst : tout est decompresse, seul le decoupage est reduit)\n");
+        fprintf(stderr, "  %s diff <ancien_fichier> <nouveau_fichier> <fichier_sortie>\n", argv[0]);
+        fprintf(stderr, "  %s validate <all|id_usine> <fichier_entree> <fichier_sortie> [--pipeline]\n", argv[0]);
+        fprintf(stderr, "  %s leaks <id_usine> <fichier_entree> <fichier_sortie> [--pipeline] [--threads <n>]\n", argv[0]);
+        fprintf(stderr, "        [--export <fichier_noeuds>]\n");
+        fprintf(stderr, "        [--cache <fichier_cache> [--cache-size <n>] [--key <fichier>] [--cache-only|--cache-store]]\n");
+        fprintf(stderr, "Modes: max, src, real, all, contrib \n");
         return 1 ;
     }
 
@@ -286,14 +429,222 @@ int main(int argc, char *argv[]) {
         else if (strcmp(argv[2], "src") == 0) mode = 2;
         else if (strcmp(argv[2], "real") == 0) mode = 3;
         else if (strcmp(argv[2],"all") == 0) mode = 4;
+        else if (strcmp(argv[2], "contrib") == 0) mode = 5;
+        else {
+            fprintf(stderr, "erreur:mode inconnu '%s'\n", argv[2]);
+            return 1;
+        }
+
+        // Options apres les arguments obligatoires 
+        for (i = 5; i < argc; i++) {
+            if (strcmp(argv[i], "--memory") == 0 && i + 1 < argc) {
+                budgetMo = atol(argv[++i]);
+            } else if (strcmp(argv[i], "--partial") == 0) {
+                partiel = 1;
+            } else if (strcmp(argv[i], "--pipeline") == 0) {
+                pipeline = 1;
+            } else if (strcmp(argv[i], "--prefix") == 0 && i + 1 < argc) {
+                intervallePrefixe(&intervalle, argv[++i]);
+                filtre = &intervalle;
+            } else if (strcmp(argv[i], "--range") == 0 && i + 2 < argc) {
+                intervalleBornes(&intervalle, argv[i + 1], argv[i + 2]);
+                filtre = &intervalle;
+                i += 2;
+            } else if (strcmp(argv[i], "--shard") == 0 && i + 1 < argc) {
+                if (sscanf(argv[++i], "%d/%d", &decoupage.shard, &decoupage.nbShards) != 2 ||
+                    decoupage.nbShards <= 0 || decoupage.shard < 0 ||
+                    decoupage.shard >= decoupage.nbShards) {
+                    fprintf(stderr, "Erreur: shard invalide '%s' (attendu k/n)\n", argv[i]);
+                    return 1;
+                }
+            } else if (strcmp(argv[i], "--bytes") == 0 && i + 1 < argc) {
+                if (sscanf(argv[++i], "%ld:%ld", &decoupage.debut, &decoupage.fin) != 2) {
+                    fprintf(stderr, "Erreur: plage invalide '%s' (attendu debut:fin)\n", argv[i]);
+                    return 1;
+                }
+            } else {
+                fprintf(stderr, "Erreur: option inconnue '%s'\n", argv[i]);
+                return 1;
+            }
+        }
+
+        if (partiel && mode == 5) {
+            fprintf(stderr, "Erreur: --partial ne gere pas le mode contrib\n");
+            return 1;
+        }
+        if (filtre != NULL && (mode == 5 || partiel || budgetMo > 0)) {
+            fprintf(stderr, "Erreur: --prefix et --range ne se combinent pas avec contrib, --partial ou --memory\n");
+            return 1;
+        }
+        if (budgetMo > 0) {
+            if (partiel || pipeline || decoupage.nbShards > 0 || decoupage.debut > 0 || decoupage.fin >= 0) {
+                fprintf(stderr, "Erreur: --memory ne se combine pas avec --partial, --shard, --bytes ou --pipeline\n");
+                return 1;
+            }
+            return traiterHistogrammeExterne(argv[3], argv[4], mode, budgetMo);
+        }
+        return traiterHistogramme(argv[3], argv[4], mode, &decoupage, partiel, pipeline, filtre);
+    }
+    else if (strcmp(argv[1], "merge") == 0) {
+        if (strcmp(argv[2], "max") == 0) mode = 1;
+        else if (strcmp(argv[2], "src") == 0) mode = 2;
+        else if (strcmp(argv[2], "real") == 0) mode = 3;
+        else if (strcmp(argv[2], "all") == 0) mode = 4;
+        else if (strcmp(argv[2], "partial") == 0) mode = 0;
+        else {
+            fprintf(stderr, "erreur:mode inconnu '%s'\n", argv[2]);
+            return 1;
+        }
+        return traiterFusion(&argv[4], argc - 4, argv[3], mode);
+    }
+    else if (strcmp(argv[1], "stats") == 0) {
+        char **rangs;
+        char **positions;
+        int nbRangs = 0;
+        int nbPositions = 0;
+        double percentileMin = -1.0;
+
+        if (strcmp(argv[2], "max") == 0) mode = 1;
+        else if (strcmp(argv[2], "src") == 0) mode = 2;
+        else if (strcmp(argv[2], "real") == 0) mode = 3;
+        else if (strcmp(argv[2], "lost") == 0) mode = 4;
+        else {
+            fprintf(stderr, "erreur:mode inconnu '%s'\n", argv[2]);
+            return 1;
+        }
+
+        rangs = (char**)malloc(sizeof(char*) * (size_t)argc);
+        positions = (char**)malloc(sizeof(char*) * (size_t)argc);
+        if (rangs == NULL || positions == NULL) {
+            fprintf(stderr, "Erreur: allocation memoire echouee\n");
+            free(rangs);
+            free(positions);
+            return 1;
+        }
+        for (i = 5; i < argc; i++) {
+            if (strcmp(argv[i], "--rank") == 0 && i + 1 < argc) {
+                rangs[nbRangs++] = argv[++i];
+            } else if (strcmp(argv[i], "--position") == 0 && i + 1 < argc) {
+                positions[nbPositions++] = argv[++i];
+            } else if (strcmp(argv[i], "--range-sum") == 0 && i + 2 < argc) {
+                intervalleBornes(&intervalle, argv[i + 1], argv[i + 2]);
+                filtre = &intervalle;
+                i += 2;
+            } else if (strcmp(argv[i], "--above") == 0 && i + 1 < argc) {
+                percentileMin = atof(argv[++i]);
+            } else {
+                fprintf(stderr, "Erreur: option inconnue '%s'\n", argv[i]);
+                free(rangs);
+                free(positions);
+                return 1;
+            }
+        }
+        i = traiterStatistiques(argv[3], argv[4], mode, rangs, nbRangs, positions, nbPositions,
+                                filtre, percentileMin);
+        free(rangs);
+        free(positions);
+        return i;
+    }
+    else if (strcmp(argv[1], "preview") == 0) {
+        int top = TOP_APERCU_DEFAUT;
+        long memoireKo = MEMOIRE_APERCU_DEFAUT_KO;
+        double fraction = 1.0;
+
+        if (strcmp(argv[2], "src") == 0) mode = 2;
+        else if (strcmp(argv[2], "real") == 0) mode = 3;
         else {
             fprintf(stderr, "erreur:mode inconnu '%s'\n", argv[2]);
             return 1;
         }
-        return traiterHistogramme(argv[3], argv[4], mode);
+        for (i = 5; i < argc; i++) {
+            if (strcmp(argv[i], "--top") == 0 && i + 1 < argc) {
+                top = atoi(argv[++i]);
+            } else if (strcmp(argv[i], "--memory-kb") == 0 && i + 1 < argc) {
+                memoireKo = atol(argv[++i]);
+            } else if (strcmp(argv[i], "--sample") == 0 && i + 1 < argc) {
+                fraction = atof(argv[++i]);
+            } else {
+                fprintf(stderr, "Erreur: option inconnue '%s'\n", argv[i]);
+                return 1;
+            }
+        }
+        if (top <= 0 || memoireKo <= 0) {
+            fprintf(stderr, "Erreur: --top et --memory-kb doivent etre positifs\n");
+            return 1;
+        }
+        return traiterApercu(argv[3], argv[4], mode, top, memoireKo, fraction);
+    }
+    else if (strcmp(argv[1], "diff") == 0) {
+        return traiterDifference(argv[2], argv[3], argv[4]);
+    }
+    else if (strcmp(argv[1], "validate") == 0) {
+        for (i = 5; i < argc; i++) {
+            if (strcmp(argv[i], "--pipeline") == 0) {
+                pipeline = 1;
+            } else {
+                fprintf(stderr, "Erreur: option inconnue '%s'\n", argv[i]);
+                return 1;
+            }
+        }
+        return traiterValidation(argv[3], argv[4],
+                                 (strcmp(argv[2], "all") == 0) ? NULL : argv[2], pipeline);
     }
     else if (strcmp (argv[1], "leaks") == 0) {
-        return traiterFuites(argv[3], argv[4], argv[2]);
+        char *fichierCache = NULL;
+        char *fichierCle = argv[3];
+        int capacite = CAPACITE_CACHE_DEFAUT;
+        int modeCache = CACHE_CHERCHER;
+        int nbThreads = 1;
+        char *fichierExport = NULL;
+
+        for (i = 5; i < argc; i++) {
+            if (strcmp(argv[i], "--pipeline") == 0) {
+                pipeline = 1;
+            } else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+                nbThreads = atoi(argv[++i]);
+                if (nbThreads < 1 || nbThreads > NB_THREADS_MAX) {
+                    fprintf(stderr, "Erreur: --threads doit etre entre 1 et %d\n", NB_THREADS_MAX);
+                    return 1;
+                }
+            } else if (strcmp(argv[i], "--cache") == 0 && i + 1 < argc) {
+                fichierCache = argv[++i];
+            } else if (strcmp(argv[i], "--cache-size") == 0 && i + 1 < argc) {
+                capacite = atoi(argv[++i]);
+            } else if (strcmp(argv[i], "--key") == 0 && i + 1 < argc) {
+                fichierCle = argv[++i];
+            } else if (strcmp(argv[i], "--export") == 0 && i + 1 < argc) {
+                fichierExport = argv[++i];
+            } else if (strcmp(argv[i], "--cache-only") == 0 || strcmp(argv[i], "--cache-store") == 0) {
+                if (modeCache != CACHE_CHERCHER) {
+                    fprintf(stderr, "Erreur: --cache-only et --cache-store sont incompatibles\n");
+                    return 1;
+                }
+                modeCache = (strcmp(argv[i], "--cache-only") == 0) ? CACHE_LECTURE_SEULE : CACHE_ECRITURE_SEULE;
+            } else {
+                fprintf(stderr, "Erreur: option inconnue '%s'\n", argv[i]);
+                return 1;
+            }
+        }
+
+        // Le pipeline est une lecture sequentielle : il n'a pas de sens avec des plages d'octets 
+        if (pipeline && nbThreads > 1) {
+            fprintf(stderr, "Erreur: --pipeline et --threads sont incompatibles\n");
+            return 1;
+        }
+        if (modeCache == CACHE_LECTURE_SEULE && fichierExport != NULL) {
+            fprintf(stderr, "Erreur: --export demande le calcul, incompatible avec --cache-only\n");
+            return 1;
+        }
+        // Le cache ne garde que le total : l'export demande toujours le calcul 
+        if (fichierCache != NULL && fichierExport == NULL) {
+            if (capacite <= 0) {
+                fprintf(stderr, "Erreur: taille de cache invalide\n");
+                return 1;
+            }
+            return traiterFuitesCache(argv[3], argv[4], argv[2], pipeline, nbThreads,
+                                      fichierCache, capacite, fichierCle, modeCache);
+        }
+        return traiterFuites(argv[3], argv[4], argv[2], pipeline, nbThreads, fichierExport, NULL);
     }
     else {
         fprintf(stderr, "Erreur: commande inconnue '%s'\n",argv[1]);
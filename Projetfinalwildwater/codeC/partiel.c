@@ -0,0 +1,130 @@
+/*
+  partiel.c - Ecriture, lecture et fusion des resultats partiels
+
+  Un partiel contient le meme cumul que l'AVL de traiterHistogramme pour
+  une partie des donnees. Relire plusieurs partiels avec insererAVL donne
+  donc le meme resultat que d'avoir lu toutes les lignes dans un seul AVL.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "avl.h"
+#include "partiel.h"
+
+// Renvoie 1 des la premiere ecriture qui echoue (disque plein) 
+static int ecrireNoeudsPartiel(NoeudAVL *racine, FILE *fichier) {
+    unsigned char longueur;
+
+    if (racine == NULL)
+        return 0;
+
+    if (ecrireNoeudsPartiel(racine->fd, fichier) != 0)
+        return 1;
+
+    longueur = (unsigned char)strlen(racine->usine.identifiant);
+    if (fwrite(&longueur, 1, 1, fichier) != 1 ||
+        fwrite(racine->usine.identifiant, 1, longueur, fichier) != longueur ||
+        fwrite(&racine->usine.capacite_max, sizeof(double), 1, fichier) != 1 ||
+        fwrite(&racine->usine.volume_capte, sizeof(double), 1, fichier) != 1 ||
+        fwrite(&racine->usine.volume_traite, sizeof(double), 1, fichier) != 1)
+        return 1;
+
+    return ecrireNoeudsPartiel(racine->fg, fichier);
+}
+
+int ecrirePartiel(NoeudAVL *racine, char *fichierSortie) {
+    int erreur;
+    FILE *fOut = fopen(fichierSortie, "wb");
+    if (fOut == NULL) {
+        fprintf(stderr, "Erreur:impossible de creer %s\n", fichierSortie);
+        return 1;
+    }
+
+    erreur = fwrite(ENTETE_PARTIEL, 1, TAILLE_ENTETE_PARTIEL, fOut) != TAILLE_ENTETE_PARTIEL ||
+             ecrireNoeudsPartiel(racine, fOut) != 0 || ferror(fOut);
+
+    if (fclose(fOut) != 0 || erreur) {
+        fprintf(stderr, "Erreur: ecriture de %s incomplete\n", fichierSortie);
+        return 1;
+    }
+    return 0;
+}
+
+int lirePartiel(char *fichierEntree, NoeudAVL **racine) {
+    FILE *fIn;
+    char entete[TAILLE_ENTETE_PARTIEL];
+    unsigned char longueur;
+    Usine usine;
+    int h;
+
+    fIn = fopen(fichierEntree, "rb");
+    if (fIn == NULL) {
+        fprintf(stderr, "Erreur: impossible d'ouvrir %s\n", fichierEntree);
+        return 1;
+    }
+
+    if (fread(entete, 1, TAILLE_ENTETE_PARTIEL, fIn) != TAILLE_ENTETE_PARTIEL ||
+        memcmp(entete, ENTETE_PARTIEL, TAILLE_ENTETE_PARTIEL) != 0) {
+        fprintf(stderr, "Erreur: %s n'est pas un fichier partiel\n", fichierEntree);
+        fclose(fIn);
+        return 1;
+    }
+
+    while (fread(&longueur, 1, 1, fIn) == 1) {
+        memset(&usine, 0, sizeof(Usine));
+        if (longueur >= sizeof(usine.identifiant) ||
+            fread(usine.identifiant, 1, longueur, fIn) != longueur ||
+            fread(&usine.capacite_max, sizeof(double), 1, fIn) != 1 ||
+            fread(&usine.volume_capte, sizeof(double), 1, fIn) != 1 ||
+            fread(&usine.volume_traite, sizeof(double), 1, fIn) != 1) {
+            fprintf(stderr, "Erreur: fichier partiel %s tronque\n", fichierEntree);
+            fclose(fIn);
+            return 1;
+        }
+        h = 0;
+        *racine = insererAVL(*racine, usine, &h);
+    }
+
+    fclose(fIn);
+    return 0;
+}
+
+int traiterFusion(char **partiels, int nbPartiels, char *fichierSortie, int mode) {
+    NoeudAVL *racine = NULL;
+    FILE *fOut;
+    int i;
+
+    for (i = 0; i < nbPartiels; i++) {
+        if (lirePartiel(partiels[i], &racine) != 0) {
+            libererAVL(racine);
+            return 1;
+        }
+    }
+
+    if (mode == 0) {
+        i = ecrirePartiel(racine, fichierSortie);
+        libererAVL(racine);
+        return i;
+    }
+
+    fOut = fopen(fichierSortie, "w");
+    if (fOut == NULL) {
+        fprintf(stderr, "Erreur:impossible de creer %s\n", fichierSortie);
+        libererAVL(racine);
+        return 1;
+    }
+
+    ecrireEnTeteHisto(fOut, mode);
+    parcoursInverseAVL(racine, fOut, mode);
+    i = ferror(fOut);
+    if (fclose(fOut) != 0 || i) {
+        fprintf(stderr, "Erreur: ecriture de %s incomplete\n", fichierSortie);
+        libererAVL(racine);
+        return 1;
+    }
+
+    printf("Fusion de %d partiels terminer avec succes\n", nbPartiels);
+    libererAVL(racine);
+    return 0;
+}
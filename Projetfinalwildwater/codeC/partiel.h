@@ -0,0 +1,32 @@
+// Resultats partiels d'histogramme pour repartir le travail sur plusieurs
+// processus : chaque processus ecrit ses usines (capacite, volume capte,
+// volume traite) dans un fichier binaire, puis "wildwater merge" les cumule.
+
+#ifndef PARTIEL_H
+#define PARTIEL_H
+
+#include "avl.h"
+
+// Debut de tout fichier partiel 
+#define ENTETE_PARTIEL "WWPART1\n"
+#define TAILLE_ENTETE_PARTIEL 8
+
+/*
+ Format : l'entete puis pour chaque usine
+   unsigned char longueur; char identifiant[longueur];
+   double capacite_max; double volume_capte; double volume_traite;
+ (ordre des octets de la machine : les processus doivent tourner
+ sur la meme architecture)
+ */
+int ecrirePartiel(NoeudAVL *racine, char *fichierSortie);
+
+// Ajoute les usines d'un fichier partiel dans l'AVL (cumul de insererAVL) 
+int lirePartiel(char *fichierEntree, NoeudAVL **racine);
+
+/*
+ Fusionne nbPartiels fichiers dans l'ordre donne puis ecrit vol_<mode>.dat
+ (mode 1 a 4) ou un nouveau partiel (mode 0).
+ */
+int traiterFusion(char **partiels, int nbPartiels, char *fichierSortie, int mode);
+
+#endif
@@ -0,0 +1,267 @@
+/*
+  pipeline.c - Lecture du fichier en pipeline (lecteur, analyseur, traitement)
+
+  Le thread lecteur enchaine les fread pendant que l'analyseur decoupe
+  les lignes (sscanf) et que le thread principal construit l'AVL ou l'arbre :
+  les attentes d'entree/sortie se recouvrent avec le traitement.
+  Une valeur NULL deposee dans un anneau signale la fin du flux.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sched.h>
+#include "pipeline.h"
+
+//      Anneau SPSC 
+
+static void initialiserAnneau(Anneau *a) {
+    atomic_init(&a->tete, 0);
+    atomic_init(&a->queue, 0);
+    atomic_init(&a->nbAttente, 0);
+    pthread_mutex_init(&a->verrou, NULL);
+    pthread_cond_init(&a->condition, NULL);
+}
+
+static void detruireAnneau(Anneau *a) {
+    pthread_mutex_destroy(&a->verrou);
+    pthread_cond_destroy(&a->condition);
+}
+
+/*
+ Vrai quand l'anneau est plein (producteur) ou vide (consommateur).
+ En seq_cst, comme nbAttente : l'autre thread voit soit notre attente,
+ soit l'indice a jour avant qu'on s'endorme.
+ */
+static int doitAttendre(Anneau *a, int producteur) {
+    size_t tete = atomic_load(&a->tete);
+    size_t queue = atomic_load(&a->queue);
+
+    return producteur ? (queue - tete == CAPACITE_ANNEAU) : (queue == tete);
+}
+
+// Quelques essais, puis sommeil jusqu'a ce que l'autre thread avance son indice 
+static void attendre(Anneau *a, int producteur) {
+    int essais;
+
+    for (essais = 0; essais < NB_ESSAIS_ATTENTE; essais++) {
+        if (!doitAttendre(a, producteur))
+            return;
+        sched_yield();
+    }
+
+    pthread_mutex_lock(&a->verrou);
+    atomic_fetch_add(&a->nbAttente, 1);
+    while (doitAttendre(a, producteur))
+        pthread_cond_wait(&a->condition, &a->verrou);
+    atomic_fetch_sub(&a->nbAttente, 1);
+    pthread_mutex_unlock(&a->verrou);
+}
+
+// Apres avoir avance un indice : reveille l'autre thread s'il dort 
+static void reveiller(Anneau *a) {
+    if (atomic_load(&a->nbAttente) == 0)
+        return;
+    pthread_mutex_lock(&a->verrou);
+    pthread_cond_broadcast(&a->condition);
+    pthread_mutex_unlock(&a->verrou);
+}
+
+// Producteur : attend une case libre puis publie l'element 
+static void deposer(Anneau *a, void *element) {
+    size_t queue = atomic_load_explicit(&a->queue, memory_order_relaxed);
+
+    if (queue - atomic_load_explicit(&a->tete, memory_order_acquire) == CAPACITE_ANNEAU)
+        attendre(a, 1);
+    a->cases[queue & (CAPACITE_ANNEAU - 1)] = element;
+    atomic_store(&a->queue, queue + 1);
+    reveiller(a);
+}
+
+// Consommateur : attend un element puis libere sa case 
+static void* retirer(Anneau *a) {
+    size_t tete = atomic_load_explicit(&a->tete, memory_order_relaxed);
+    void *element;
+
+    if (atomic_load_explicit(&a->queue, memory_order_acquire) == tete)
+        attendre(a, 0);
+    element = a->cases[tete & (CAPACITE_ANNEAU - 1)];
+    atomic_store(&a->tete, tete + 1);
+    reveiller(a);
+    return element;
+}
+
+//      Threads 
+
+static void* executerLecteur(void *arg) {
+    Pipeline *p = (Pipeline*)arg;
+    BlocTexte *bloc;
+
+    while (!atomic_load_explicit(&p->arret, memory_order_relaxed)) {
+        bloc = (BlocTexte*)retirer(&p->blocsLibres);
+        bloc->taille = fread(bloc->donnees, 1, TAILLE_BLOC, p->f);
+        if (bloc->taille == 0)
+            break;
+        deposer(&p->blocsPleins, bloc);
+    }
+
+    deposer(&p->blocsPleins, NULL);
+    return NULL;
+}
+
+/*
+ Ajoute une ligne complete au lot courant. On coupe les lignes comme fgets
+ (au plus TAILLE_LIGNE - 1 caracteres) pour garder le meme resultat que la
+ lecture directe.
+ */
+static void emettreLigne(Pipeline *p, LotEnregistrements **lot, char *ligne) {
+    Enregistrement *e;
+
+    if ((*lot)->nb == TAILLE_LOT) {
+        deposer(&p->lotsPleins, *lot);
+        *lot = (LotEnregistrements*)retirer(&p->lotsLibres);
+        (*lot)->nb = 0;
+    }
+    e = &(*lot)->e[(*lot)->nb];
+    e->nbChamps = decouperLigne(ligne, e->col1, e->col2, e->col3, e->col4, e->col5);
+    (*lot)->nb++;
+}
+
+static void* executerAnalyseur(void *arg) {
+    Pipeline *p = (Pipeline*)arg;
+    BlocTexte *bloc;
+    LotEnregistrements *lot;
+    char ligne[TAILLE_LIGNE];
+    size_t longueur = 0, i, n;
+    char *nl;
+    long position = p->position;
+    long debutLigne = position;
+    int termine = 0;
+
+    lot = (LotEnregistrements*)retirer(&p->lotsLibres);
+    lot->nb = 0;
+
+    while ((bloc = (BlocTexte*)retirer(&p->blocsPleins)) != NULL) {
+        i = 0;
+        while (!termine && i < bloc->taille) {
+            // copier jusqu'a la fin de ligne ou jusqu'a remplir le tampon 
+            n = bloc->taille - i;
+            if (n > TAILLE_LIGNE - 1 - longueur)
+                n = TAILLE_LIGNE - 1 - longueur;
+            nl = memchr(bloc->donnees + i, '\n', n);
+            if (nl != NULL)
+                n = (size_t)(nl - (bloc->donnees + i)) + 1;
+
+            memcpy(ligne + longueur, bloc->donnees + i, n);
+            longueur += n;
+            i += n;
+            position += (long)n;
+
+            if (nl != NULL || longueur == TAILLE_LIGNE - 1) {
+                if (p->fin >= 0 && debutLigne >= p->fin) {
+                    termine = 1;
+                    atomic_store_explicit(&p->arret, 1, memory_order_relaxed);
+                    break;
+                }
+                ligne[longueur] = '\0';
+                emettreLigne(p, &lot, ligne);
+                longueur = 0;
+                debutLigne = position;
+            }
+        }
+        deposer(&p->blocsLibres, bloc);
+    }
+
+    // derniere ligne sans retour a la ligne 
+    if (!termine && longueur > 0 && (p->fin < 0 || debutLigne < p->fin)) {
+        ligne[longueur] = '\0';
+        emettreLigne(p, &lot, ligne);
+    }
+
+    if (lot->nb > 0)
+        deposer(&p->lotsPleins, lot);
+    deposer(&p->lotsPleins, NULL);
+    return NULL;
+}
+
+//      Interface 
+
+Pipeline* demarrerPipeline(FILE *f, long position, long fin) {
+    Pipeline *p;
+    int i;
+
+    p = (Pipeline*)malloc(sizeof(Pipeline));
+    if (p == NULL) {
+        fprintf(stderr, "Erreur: allocation memoire echouee pour Pipeline\n");
+        exit(EXIT_FAILURE);
+    }
+    p->f = f;
+    p->position = position;
+    p->fin = fin;
+    atomic_init(&p->arret, 0);
+    initialiserAnneau(&p->blocsPleins);
+    initialiserAnneau(&p->blocsLibres);
+    initialiserAnneau(&p->lotsPleins);
+    initialiserAnneau(&p->lotsLibres);
+
+    // Avant le demarrage des threads, le thread principal remplit les anneaux de retour 
+    for (i = 0; i < NB_BLOCS; i++) {
+        p->blocs[i] = (BlocTexte*)malloc(sizeof(BlocTexte));
+        if (p->blocs[i] == NULL) {
+            fprintf(stderr, "Erreur: allocation memoire echouee pour BlocTexte\n");
+            exit(EXIT_FAILURE);
+        }
+        deposer(&p->blocsLibres, p->blocs[i]);
+    }
+    for (i = 0; i < NB_LOTS; i++) {
+        p->lots[i] = (LotEnregistrements*)malloc(sizeof(LotEnregistrements));
+        if (p->lots[i] == NULL) {
+            fprintf(stderr, "Erreur: allocation memoire echouee pour LotEnregistrements\n");
+            exit(EXIT_FAILURE);
+        }
+        deposer(&p->lotsLibres, p->lots[i]);
+    }
+
+    if (pthread_create(&p->threadLecteur, NULL, executerLecteur, p) != 0 ||
+        pthread_create(&p->threadAnalyseur, NULL, executerAnalyseur, p) != 0) {
+        fprintf(stderr, "Erreur: creation des threads impossible\n");
+        exit(EXIT_FAILURE);
+    }
+    return p;
+}
+
+LotEnregistrements* lotSuivant(Pipeline *p) {
+    return (LotEnregistrements*)retirer(&p->lotsPleins);
+}
+
+void rendreLot(Pipeline *p, LotEnregistrements *lot) {
+    deposer(&p->lotsLibres, lot);
+}
+
+/*
+ Si le traitement s'arrete avant la fin, on demande l'arret au lecteur et
+ on vide les lots restants jusqu'au NULL pour que l'analyseur se termine.
+ */
+void arreterPipeline(Pipeline *p, int termine) {
+    LotEnregistrements *lot;
+    int i;
+
+    if (!termine) {
+        atomic_store_explicit(&p->arret, 1, memory_order_relaxed);
+        while ((lot = lotSuivant(p)) != NULL)
+            rendreLot(p, lot);
+    }
+
+    pthread_join(p->threadLecteur, NULL);
+    pthread_join(p->threadAnalyseur, NULL);
+
+    for (i = 0; i < NB_BLOCS; i++)
+        free(p->blocs[i]);
+    for (i = 0; i < NB_LOTS; i++)
+        free(p->lots[i]);
+    detruireAnneau(&p->blocsPleins);
+    detruireAnneau(&p->blocsLibres);
+    detruireAnneau(&p->lotsPleins);
+    detruireAnneau(&p->lotsLibres);
+    free(p);
+}
@@ -0,0 +1,82 @@
+// Lecture en pipeline sur trois threads :
+//   lecteur (fread de gros blocs) -> analyseur (decoupage en colonnes) -> traitement
+// Les etages sont relies par des anneaux sans verrou a un seul producteur
+// et un seul consommateur ; un thread qui attend trop longtemps s'endort sur
+// une variable de condition au lieu de tourner. Les blocs et les lots d'enregistrements sont
+// recycles par des anneaux de retour : la memoire utilisee est bornee.
+
+#ifndef PIPELINE_H
+#define PIPELINE_H
+
+#include <stdio.h>
+#include <stddef.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include "lecture.h"
+
+#define TAILLE_BLOC (256 * 1024)
+#define NB_BLOCS 4
+#define TAILLE_LOT 256
+#define NB_LOTS 8
+// Puissance de 2, plus grande que NB_BLOCS + 1 et NB_LOTS + 1 
+#define CAPACITE_ANNEAU 16
+#define TAILLE_CACHE 64
+// Essais (sched_yield) avant de s'endormir sur la variable de condition 
+#define NB_ESSAIS_ATTENTE 64
+
+/*
+ Anneau a un producteur et un consommateur : seul le producteur avance
+ queue, seul le consommateur avance tete. Chaque indice est sur sa propre
+ ligne de cache pour que les deux threads ne se genent pas. Le verrou et
+ la condition ne servent qu'aux threads endormis (nbAttente > 0).
+ */
+typedef struct anneau {
+    void *cases[CAPACITE_ANNEAU];
+    _Alignas(TAILLE_CACHE) atomic_size_t tete;
+    _Alignas(TAILLE_CACHE) atomic_size_t queue;
+    _Alignas(TAILLE_CACHE) atomic_int nbAttente;
+    pthread_mutex_t verrou;
+    pthread_cond_t condition;
+} Anneau;
+
+// Bloc de texte brut lu par le thread lecteur 
+typedef struct blocTexte {
+    size_t taille;
+    char donnees[TAILLE_BLOC];
+} BlocTexte;
+
+// Lot de lignes decoupees par le thread analyseur 
+typedef struct lotEnregistrements {
+    int nb;
+    Enregistrement e[TAILLE_LOT];
+} LotEnregistrements;
+
+typedef struct pipeline {
+    FILE *f;
+    long position;                  // octet de depart dans le fichier
+    long fin;                       // -1 = jusqu'a la fin
+    atomic_int arret;               // demande d'arret au thread lecteur
+
+    Anneau blocsPleins;             // lecteur -> analyseur
+    Anneau blocsLibres;             // analyseur -> lecteur
+    Anneau lotsPleins;              // analyseur -> traitement
+    Anneau lotsLibres;              // traitement -> analyseur
+
+    BlocTexte *blocs[NB_BLOCS];
+    LotEnregistrements *lots[NB_LOTS];
+
+    pthread_t threadLecteur;
+    pthread_t threadAnalyseur;
+} Pipeline;
+
+// Demarre les threads ; position = octet courant de f (apres debutDecoupage) 
+Pipeline* demarrerPipeline(FILE *f, long position, long fin);
+
+// Lot suivant (NULL a la fin du fichier), a rendre avec rendreLot 
+LotEnregistrements* lotSuivant(Pipeline *p);
+void rendreLot(Pipeline *p, LotEnregistrements *lot);
+
+// Arrete les threads et libere le pipeline ; termine = 1 si lotSuivant a deja renvoye NULL 
+void arreterPipeline(Pipeline *p, int termine);
+
+#endif
@@ -0,0 +1,160 @@
+/*
+  stats.c - Rapport de percentiles et de rangs
+
+  On agrege les usines dans l'AVL des identifiants comme pour l'histogramme.
+  Cet arbre est trie par identifiant : il ne suffit pas pour les percentiles
+  ou le rang par valeur. On construit donc un second AVL trie par valeur,
+  ce qui revient a un tri (O(n log n)) et double la memoire des usines.
+  Ensuite chaque percentile ou rang se lit en O(log n) grace aux tailles
+  des sous-arbres. Les requetes par identifiant (--position, --range-sum)
+  n'utilisent que le premier arbre.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "avl.h"
+#include "lecture.h"
+#include "stats.h"
+
+// Indice (a partir de 0, ordre croissant) du percentile p, methode du rang le plus proche 
+static int indicePercentile(int n, double p) {
+    int k = (int)ceil(p / 100.0 * n) - 1;
+    if (k < 0)
+        k = 0;
+    if (k > n - 1)
+        k = n - 1;
+    return k;
+}
+
+static void ecrirePercentile(FILE *fOut, char *nom, NoeudAVL *classement, int k, int mode) {
+    NoeudAVL *noeud = selectionnerAVL(classement, k);
+    fprintf(fOut, "%s;%.6f\n", nom, valeurUsine(&noeud->usine, mode) / 1000.0);
+}
+
+/*
+ Ecrit en ordre decroissant les usines de rang >= k.
+ decalage = nombre d'usines avant ce sous-arbre ; on ne descend a gauche
+ que si elle contient des rangs >= k : O(log n + nombre d'usines ecrites).
+ */
+static void ecrireAuDessus(NoeudAVL *a, int k, int decalage, double percentile, FILE *fOut, int mode) {
+    int rang;
+
+    if (a == NULL)
+        return;
+
+    rang = decalage + tailleAVL(a->fg);
+    ecrireAuDessus(a->fd, k, rang + 1, percentile, fOut, mode);
+    if (rang >= k) {
+        fprintf(fOut, "above p%g;%s;%.6f\n", percentile, a->usine.identifiant,
+                valeurUsine(&a->usine, mode) / 1000.0);
+    }
+    if (rang - 1 >= k)
+        ecrireAuDessus(a->fg, k, decalage, percentile, fOut, mode);
+}
+
+int traiterStatistiques(char *fichierEntree, char *fichierSortie, int mode,
+                        char **rangs, int nbRangs, char **positions, int nbPositions,
+                        Intervalle *somme, double percentileMin) {
+    FILE *fIn, *fOut;
+    pid_t pid;
+    Lecteur lecteur;
+    Enregistrement *e;
+    NoeudAVL *racine = NULL;
+    NoeudAVL *classement = NULL;
+    NoeudAVL *noeud;
+    Usine usine;
+    Usine cumul;
+    double total;
+    int n, i, h;
+
+    fIn = ouvrirEntree(fichierEntree, &pid);
+    if (fIn == NULL) {
+        fprintf(stderr, "Erreur: impossible d'ouvrir %s\n", fichierEntree);
+        return 1;
+    }
+
+    ouvrirLecteur(&lecteur, fIn, NULL, 0);
+    while ((e = lireEnregistrement(&lecteur)) != NULL) {
+        if (analyserEnregistrementHisto(e, &usine, NULL) == LIGNE_IGNOREE)
+            continue;
+        h = 0;
+        racine = insererAVL(racine, usine, &h);
+    }
+    fermerLecteur(&lecteur);
+    if (fermerEntree(fIn, pid) != 0) {
+        libererAVL(racine);
+        return 1;
+    }
+
+    fOut = fopen(fichierSortie, "w");
+    if (fOut == NULL) {
+        fprintf(stderr, "Erreur:impossible de creer %s\n", fichierSortie);
+        libererAVL(racine);
+        return 1;
+    }
+
+    classement = construireAVLValeur(racine, NULL, mode);
+    n = tailleAVL(classement);
+
+    // Total lu directement dans les sommes de la racine 
+    total = 0.0;
+    if (racine != NULL) {
+        if (mode == 1) total = racine->somme_max;
+        else if (mode == 2) total = racine->somme_capte;
+        else if (mode == 3) total = racine->somme_traite;
+        else total = racine->somme_capte - racine->somme_traite;
+    }
+
+    fprintf(fOut, "statistic;value (M.m3.year-1)\n");
+    fprintf(fOut, "count;%d\n", n);
+    fprintf(fOut, "total;%.6f\n", total / 1000.0);
+    if (n > 0) {
+        ecrirePercentile(fOut, "min", classement, 0, mode);
+        ecrirePercentile(fOut, "p50", classement, indicePercentile(n, 50.0), mode);
+        ecrirePercentile(fOut, "p90", classement, indicePercentile(n, 90.0), mode);
+        ecrirePercentile(fOut, "p95", classement, indicePercentile(n, 95.0), mode);
+        ecrirePercentile(fOut, "p99", classement, indicePercentile(n, 99.0), mode);
+        ecrirePercentile(fOut, "max", classement, n - 1, mode);
+    }
+
+    // Rang 1 = plus grande valeur 
+    for (i = 0; i < nbRangs; i++) {
+        noeud = rechercherAVL(racine, rangs[i]);
+        if (noeud == NULL) {
+            fprintf(fOut, "rank;%s;-1\n", rangs[i]);
+        } else {
+            fprintf(fOut, "rank;%s;%d;%.6f\n", rangs[i],
+                    n - rangValeurAVL(classement, valeurUsine(&noeud->usine, mode), rangs[i], mode),
+                    valeurUsine(&noeud->usine, mode) / 1000.0);
+        }
+    }
+
+    /*
+     Requetes sur l'ordre des identifiants : elles n'utilisent que l'AVL
+     des identifiants (tailles et sommes des sous-arbres), pas le classement.
+     Position 1 = plus petit identifiant.
+     */
+    for (i = 0; i < nbPositions; i++) {
+        if (rechercherAVL(racine, positions[i]) == NULL)
+            fprintf(fOut, "position;%s;-1\n", positions[i]);
+        else
+            fprintf(fOut, "position;%s;%d\n", positions[i], rangAVL(racine, positions[i]) + 1);
+    }
+
+    if (somme != NULL) {
+        h = sommeIntervalleAVL(racine, somme->debut, somme->fin, &cumul);
+        fprintf(fOut, "range sum;%s;%s;%d;%.6f\n", somme->debut, somme->fin, h,
+                valeurUsine(&cumul, mode) / 1000.0);
+    }
+
+    if (percentileMin >= 0 && n > 0)
+        ecrireAuDessus(classement, indicePercentile(n, percentileMin) + 1, 0, percentileMin, fOut, mode);
+
+    fclose(fOut);
+    printf("Statistiques calculees sur %d usines\n", n);
+    libererAVL(classement);
+    libererAVL(racine);
+    return 0;
+}
@@ -0,0 +1,21 @@
+// Statistiques sur les usines (mediane, percentiles, rang d'une usine)
+// calculees avec les statistiques d'ordre de l'AVL. Les requetes par valeur
+// demandent un second AVL classe par valeur (O(n log n), memoire doublee).
+
+#ifndef STATS_H
+#define STATS_H
+
+#include "avl.h"
+
+/*
+ mode: 1=max, 2=src, 3=real, 4=lost (volume perdu)
+ rangs: identifiants dont on veut le rang (1 = plus grande valeur)
+ positions: identifiants dont on veut la position dans l'ordre des identifiants
+ somme: si non NULL, nombre d'usines et somme de la valeur entre deux identifiants
+ percentileMin: si >= 0, liste les usines au-dessus de ce percentile
+ */
+int traiterStatistiques(char *fichierEntree, char *fichierSortie, int mode,
+                        char **rangs, int nbRangs, char **positions, int nbPositions,
+                        Intervalle *somme, double percentileMin);
+
+#endif
@@ -0,0 +1,412 @@
+/*
+  validation.c - Controle du reseau de distribution
+
+  traiterFuites ignore une arete dont le parent n'est pas encore dans
+  l'arbre, et cree une nouvelle copie d'un noeud a chaque arete qui y mene :
+  un noeud a deux parents est compte deux fois, les aretes suivantes partent
+  de la derniere copie, et un cycle ne boucle pas (les noeuds sont neufs).
+  Ces cas restent signales ici, car ils trahissent en general une erreur
+  dans le fichier.
+  Ici chaque noeud est garde une seule fois dans une table de hachage
+  (nom -> noeud) avec son premier parent ; les controles se font pendant
+  la lecture ou par des parcours lineaires des noeuds a la fin.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include "lecture.h"
+#include "validation.h"
+
+#define AUCUN -1
+
+// Type de noeud 
+#define NOEUD_AUTRE 0
+#define NOEUD_USINE 1
+#define NOEUD_STOCKAGE 2
+
+// Etat pour la recherche de cycles 
+#define NON_VU 0
+#define EN_COURS 1
+#define TERMINE 2
+
+// Types de problemes 
+#define PARENT_DOUBLE 0
+#define CYCLE 1
+#define ORPHELIN 2
+#define AVANT_PARENT 3
+#define STOCKAGE_NON_ATTEINT 4
+#define NB_CONTROLES 5
+
+#define TAILLE_EXEMPLE 200
+
+static const char *nomsControles[NB_CONTROLES] = {
+    "duplicate parents",
+    "cycles",
+    "orphan edges",
+    "edges before parent",
+    "unreachable storage"
+};
+
+typedef struct noeudReseau {
+    char nom[TAILLE_COLONNE];
+    int parent;         // premier parent rencontre (AUCUN si racine ou inconnu)
+    int usine;          // usine de l'arete qui a cree le lien
+    long ligne;         // ligne de cette arete
+    char type;
+    char alimentee;     // usine : au moins un captage
+    char avantParent;   // arete lue avant celle de son parent
+    char etat;
+    char atteint;       // atteint depuis une usine alimentee
+} NoeudReseau;
+
+// Toutes les aretes lues, y compris celles d'un second parent 
+typedef struct lienReseau {
+    int parent;
+    int enfant;
+} LienReseau;
+
+typedef struct reseau {
+    NoeudReseau *noeuds;
+    int nb;
+    int capacite;
+    int *table;
+    int tailleTable;    // puissance de 2
+    LienReseau *liens;
+    int nbLiens;
+    int capaciteLiens;
+} Reseau;
+
+typedef struct controle {
+    long nb;
+    int nbExemples;
+    char exemples[NB_EXEMPLES][TAILLE_EXEMPLE];
+} Controle;
+
+//      Table de hachage des noeuds 
+
+static void initialiserReseau(Reseau *r) {
+    int i;
+
+    r->nb = 0;
+    r->capacite = 1024;
+    r->tailleTable = 2048;
+    r->nbLiens = 0;
+    r->capaciteLiens = 1024;
+    r->noeuds = (NoeudReseau*)malloc(sizeof(NoeudReseau) * (size_t)r->capacite);
+    r->table = (int*)malloc(sizeof(int) * (size_t)r->tailleTable);
+    r->liens = (LienReseau*)malloc(sizeof(LienReseau) * (size_t)r->capaciteLiens);
+    if (r->noeuds == NULL || r->table == NULL || r->liens == NULL) {
+        fprintf(stderr, "Erreur: allocation memoire echouee pour la validation\n");
+        exit(EXIT_FAILURE);
+    }
+    for (i = 0; i < r->tailleTable; i++)
+        r->table[i] = CASE_VIDE;
+}
+
+static void libererReseau(Reseau *r) {
+    free(r->noeuds);
+    free(r->table);
+    free(r->liens);
+}
+
+// Table commune de lecture.h : les cases contiennent des indices dans r->noeuds 
+static int caseNoeud(Reseau *r, char *nom) {
+    return chercherCaseTable(r->table, r->tailleTable, nom, r->noeuds,
+                             sizeof(NoeudReseau), offsetof(NoeudReseau, nom));
+}
+
+// Double la table quand elle est a moitie pleine 
+static void agrandirTable(Reseau *r) {
+    int i;
+
+    free(r->table);
+    r->tailleTable *= 2;
+    r->table = (int*)malloc(sizeof(int) * (size_t)r->tailleTable);
+    if (r->table == NULL) {
+        fprintf(stderr, "Erreur: allocation memoire echouee pour la validation\n");
+        exit(EXIT_FAILURE);
+    }
+    for (i = 0; i < r->tailleTable; i++)
+        r->table[i] = CASE_VIDE;
+    for (i = 0; i < r->nb; i++)
+        r->table[caseNoeud(r, r->noeuds[i].nom)] = i;
+}
+
+// Renvoie l'indice du noeud, en le creant s'il n'existe pas 
+static int obtenirNoeud(Reseau *r, char *nom) {
+    int c = caseNoeud(r, nom);
+    NoeudReseau *n;
+
+    if (r->table[c] != CASE_VIDE)
+        return r->table[c];
+
+    if (r->nb == r->capacite) {
+        r->capacite *= 2;
+        r->noeuds = (NoeudReseau*)realloc(r->noeuds, sizeof(NoeudReseau) * (size_t)r->capacite);
+        if (r->noeuds == NULL) {
+            fprintf(stderr, "Erreur: allocation memoire echouee pour la validation\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+    n = &r->noeuds[r->nb];
+    strcpy(n->nom, nom);
+    n->parent = AUCUN;
+    n->usine = AUCUN;
+    n->ligne = 0;
+    n->type = NOEUD_AUTRE;
+    n->alimentee = 0;
+    n->avantParent = 0;
+    n->etat = NON_VU;
+    n->atteint = 0;
+    r->table[c] = r->nb;
+    r->nb++;
+
+    if (2 * r->nb > r->tailleTable)
+        agrandirTable(r);
+    return r->nb - 1;
+}
+
+static void signaler(Controle *c, const char *format, ...) {
+    va_list args;
+
+    c->nb++;
+    if (c->nbExemples >= NB_EXEMPLES)
+        return;
+    va_start(args, format);
+    vsnprintf(c->exemples[c->nbExemples], TAILLE_EXEMPLE, format, args);
+    va_end(args);
+    c->nbExemples++;
+}
+
+// Noeud deja rattache a une usine (usine elle-meme ou noeud avec un parent) 
+static int estConnu(NoeudReseau *n) {
+    return n->type == NOEUD_USINE || n->parent != AUCUN;
+}
+
+//      Aretes 
+
+static void ajouterArete(Reseau *r, Controle *controles, char *usine, char *parent,
+                         char *enfant, int stockage, long ligne) {
+    int u = obtenirNoeud(r, usine);
+    int p = obtenirNoeud(r, parent);
+    int e = obtenirNoeud(r, enfant);
+    NoeudReseau *n;
+
+    r->noeuds[u].type = NOEUD_USINE;
+    if (r->nbLiens == r->capaciteLiens) {
+        r->capaciteLiens *= 2;
+        r->liens = (LienReseau*)realloc(r->liens, sizeof(LienReseau) * (size_t)r->capaciteLiens);
+        if (r->liens == NULL) {
+            fprintf(stderr, "Erreur: allocation memoire echouee pour la validation\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+    r->liens[r->nbLiens].parent = p;
+    r->liens[r->nbLiens].enfant = e;
+    r->nbLiens++;
+
+    n = &r->noeuds[e];
+    if (stockage)
+        n->type = NOEUD_STOCKAGE;
+
+    // Un seul parent par noeud : traiterFuites creerait un second noeud 
+    if (n->parent != AUCUN) {
+        signaler(&controles[PARENT_DOUBLE], "%ld;%s;%s then %s (line %ld)",
+                 ligne, enfant, r->noeuds[n->parent].nom, parent, n->ligne);
+        return;
+    }
+    n->parent = p;
+    n->usine = u;
+    n->ligne = ligne;
+    n->avantParent = !estConnu(&r->noeuds[p]);
+}
+
+/*
+ Remonte les parents depuis chaque noeud non vu. Chaque noeud n'a qu'un
+ parent : un chemin qui retombe sur un noeud EN_COURS ferme un cycle.
+ Chaque noeud est visite une fois, le parcours reste lineaire.
+ */
+static void chercherCycles(Reseau *r, Controle *controle) {
+    int i, j, k, longueur;
+
+    for (i = 0; i < r->nb; i++) {
+        j = i;
+        while (j != AUCUN && r->noeuds[j].etat == NON_VU) {
+            r->noeuds[j].etat = EN_COURS;
+            j = r->noeuds[j].parent;
+        }
+        if (j != AUCUN && r->noeuds[j].etat == EN_COURS) {
+            longueur = 1;
+            for (k = r->noeuds[j].parent; k != j; k = r->noeuds[k].parent)
+                longueur++;
+            signaler(controle, "%ld;%s;%d nodes", r->noeuds[j].ligne, r->noeuds[j].nom, longueur);
+        }
+        // Marque le reste du chemin 
+        j = i;
+        while (j != AUCUN && r->noeuds[j].etat == EN_COURS) {
+            r->noeuds[j].etat = TERMINE;
+            j = r->noeuds[j].parent;
+        }
+    }
+}
+
+/*
+ Parcours en largeur depuis les usines qui ont un captage, en suivant
+ toutes les aretes lues (listes d'enfants construites comme un tri par
+ comptage). Un stockage jamais atteint ne recoit pas d'eau.
+ */
+static void marquerAtteints(Reseau *r) {
+    int *debut, *enfants, *file;
+    int i, j, tete = 0, queue = 0;
+
+    debut = (int*)calloc((size_t)r->nb + 1, sizeof(int));
+    enfants = (int*)malloc(sizeof(int) * (size_t)(r->nbLiens > 0 ? r->nbLiens : 1));
+    file = (int*)malloc(sizeof(int) * (size_t)(r->nb > 0 ? r->nb : 1));
+    if (debut == NULL || enfants == NULL || file == NULL) {
+        fprintf(stderr, "Erreur: allocation memoire echouee pour la validation\n");
+        exit(EXIT_FAILURE);
+    }
+
+    // Enfants de i : enfants[debut[i] .. debut[i + 1] - 1] 
+    for (i = 0; i < r->nbLiens; i++)
+        debut[r->liens[i].parent + 1]++;
+    for (i = 0; i < r->nb; i++)
+        debut[i + 1] += debut[i];
+    memcpy(file, debut, sizeof(int) * (size_t)r->nb);
+    for (i = 0; i < r->nbLiens; i++)
+        enfants[file[r->liens[i].parent]++] = r->liens[i].enfant;
+
+    // La file reprend le tableau qui a servi a remplir les listes 
+    for (i = 0; i < r->nb; i++) {
+        if (r->noeuds[i].type == NOEUD_USINE && r->noeuds[i].alimentee) {
+            r->noeuds[i].atteint = 1;
+            file[queue++] = i;
+        }
+    }
+    while (tete < queue) {
+        i = file[tete++];
+        for (j = debut[i]; j < debut[i + 1]; j++) {
+            if (!r->noeuds[enfants[j]].atteint) {
+                r->noeuds[enfants[j]].atteint = 1;
+                file[queue++] = enfants[j];
+            }
+        }
+    }
+
+    free(debut);
+    free(enfants);
+    free(file);
+}
+
+static void verifierNoeuds(Reseau *r, Controle *controles) {
+    int i;
+    NoeudReseau *n, *p;
+
+    for (i = 0; i < r->nb; i++) {
+        n = &r->noeuds[i];
+        if (n->parent == AUCUN)
+            continue;
+        p = &r->noeuds[n->parent];
+        if (!estConnu(p)) {
+            signaler(&controles[ORPHELIN], "%ld;%s;unknown parent %s", n->ligne, n->nom, p->nom);
+        } else if (n->avantParent) {
+            signaler(&controles[AVANT_PARENT], "%ld;%s;parent %s defined later (line %ld)",
+                     n->ligne, n->nom, p->nom, p->ligne);
+        }
+        if (n->type == NOEUD_STOCKAGE && !n->atteint) {
+            signaler(&controles[STOCKAGE_NON_ATTEINT], "%ld;%s;not reached from a fed plant (%s)",
+                     n->ligne, n->nom, r->noeuds[n->usine].nom);
+        }
+    }
+}
+
+int traiterValidation(char *fichierEntree, char *fichierSortie, char *idUsine, int pipeline) {
+    FILE *fIn, *fOut;
+    pid_t pid;
+    Lecteur lecteur;
+    Enregistrement *e;
+    Reseau reseau;
+    Controle controles[NB_CONTROLES];
+    long ligne = 0, nbAretes = 0, nbProblemes = 0;
+    int i, k, u;
+
+    fIn = ouvrirEntree(fichierEntree, &pid);
+    if (fIn == NULL) {
+        fprintf(stderr, "Erreur: impossible d'ouvrir %s\n", fichierEntree);
+        return 1;
+    }
+    ouvrirLecteur(&lecteur, fIn, NULL, pipeline);
+    initialiserReseau(&reseau);
+    memset(controles, 0, sizeof(controles));
+
+    while ((e = lireEnregistrement(&lecteur)) != NULL) {
+        ligne++;
+        if (e->nbChamps < 3 || strcmp(e->col3, "-") == 0 || strlen(e->col3) == 0)
+            continue;
+
+        // Captage -;Source;Usine;volume;fuite : l'usine recoit de l'eau 
+        if (strcmp(e->col1, "-") == 0 && strcmp(e->col4, "-") != 0) {
+            if (idUsine == NULL || strcmp(e->col3, idUsine) == 0) {
+                u = obtenirNoeud(&reseau, e->col3);
+                reseau.noeuds[u].type = NOEUD_USINE;
+                reseau.noeuds[u].alimentee = 1;
+            }
+            continue;
+        }
+
+        // Usine -> stockage (-;Usine;Stockage;-;fuite) 
+        if (strcmp(e->col1, "-") == 0) {
+            if (idUsine == NULL || strcmp(e->col2, idUsine) == 0) {
+                ajouterArete(&reseau, controles, e->col2, e->col2, e->col3, 1, ligne);
+                nbAretes++;
+            }
+            continue;
+        }
+
+        // Distribution (Usine;Amont;Aval;-;fuite) 
+        if (idUsine == NULL || strcmp(e->col1, idUsine) == 0) {
+            ajouterArete(&reseau, controles, e->col1, e->col2, e->col3, 0, ligne);
+            nbAretes++;
+        }
+    }
+
+    fermerLecteur(&lecteur);
+    if (fermerEntree(fIn, pid) != 0) {
+        libererReseau(&reseau);
+        return 1;
+    }
+
+    chercherCycles(&reseau, &controles[CYCLE]);
+    marquerAtteints(&reseau);
+    verifierNoeuds(&reseau, controles);
+
+    fOut = fopen(fichierSortie, "w");
+    if (fOut == NULL) {
+        fprintf(stderr, "Erreur:impossible de creer %s\n", fichierSortie);
+        libererReseau(&reseau);
+        return 1;
+    }
+
+    fprintf(fOut, "check;count\n");
+    fprintf(fOut, "lines;%ld\n", ligne);
+    fprintf(fOut, "nodes;%d\n", reseau.nb);
+    fprintf(fOut, "edges;%ld\n", nbAretes);
+    for (k = 0; k < NB_CONTROLES; k++) {
+        fprintf(fOut, "%s;%ld\n", nomsControles[k], controles[k].nb);
+        nbProblemes += controles[k].nb;
+    }
+    fprintf(fOut, "check;line;node;detail\n");
+    for (k = 0; k < NB_CONTROLES; k++) {
+        for (i = 0; i < controles[k].nbExemples; i++)
+            fprintf(fOut, "%s;%s\n", nomsControles[k], controles[k].exemples[i]);
+    }
+    fclose(fOut);
+
+    printf("Validation de %s: %d noeuds, %ld aretes, %ld probleme(s)\n",
+           (idUsine == NULL) ? "tout le fichier" : idUsine, reseau.nb, nbAretes, nbProblemes);
+    libererReseau(&reseau);
+    return (nbProblemes > 0) ? 2 : 0;
+}
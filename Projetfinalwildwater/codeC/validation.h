@@ -0,0 +1,18 @@
+// Verification du reseau de distribution avant le calcul des fuites :
+// parents multiples, cycles, aretes orphelines et stockages non atteints,
+// en une seule lecture du fichier avec une table de hachage des noeuds.
+
+#ifndef VALIDATION_H
+#define VALIDATION_H
+
+// Nombre d'exemples gardes pour chaque type de probleme 
+#define NB_EXEMPLES 5
+
+/*
+ idUsine: reseau d'une seule usine, ou NULL pour tout le fichier
+ Renvoie 0 si le reseau est correct, 2 si des problemes ont ete trouves
+ (1 en cas d'erreur de lecture ou d'ecriture).
+ */
+int traiterValidation(char *fichierEntree, char *fichierSortie, char *idUsine, int pipeline);
+
+#endif
@@ -0,0 +1,159 @@
+#!/bin/bash
+
+# Test de non-regression : chaque mode de wildwater doit redonner les sorties de
+# reference (tests/reference), produites par la version d'origine du programme,
+# sur donnees.dat et sur reseau_desordre.dat (troncons avant leur parent, noeud
+# a deux parents, cycles). Usage : ./tests/regression.sh
+#
+# Les histogrammes doivent etre identiques a l'octet pres. Les fuites sont
+# calculees en double depuis le passage des volumes en double, la version
+# d'origine travaillait en float : on accepte un ecart relatif de 1e-5.
+# Les fuites avec --threads doivent en plus etre identiques a la lecture
+# sequentielle.
+
+TESTS_DIR="$(cd "$(dirname "$0")" && pwd)"
+SCRIPT_DIR="$(dirname "$TESTS_DIR")"
+CODE_C_DIR="$SCRIPT_DIR/codeC"
+REFERENCE_DIR="$TESTS_DIR/reference"
+WILDWATER="$CODE_C_DIR/wildwater"
+DONNEES="$SCRIPT_DIR/donnees.dat"
+DESORDRE="$TESTS_DIR/reseau_desordre.dat"
+
+SORTIE_DIR="$(mktemp -d)" || exit 1
+trap 'rm -rf "$SORTIE_DIR"' EXIT
+
+NB_ECHECS=0
+NB_TESTS=0
+
+echec() {
+    echo "ECHEC : $1"
+    NB_ECHECS=$((NB_ECHECS + 1))
+}
+
+# Compare un fichier produit a sa reference, a l'octet pres
+comparer() {
+    NB_TESTS=$((NB_TESTS + 1))
+    if ! cmp -s "$1" "$2"; then
+        echec "$3 ($(basename "$2"))"
+        diff "$2" "$1" | head -5
+    fi
+}
+
+# Compare deux fichiers "usine;fuites" ligne a ligne, avec la tolerance des fuites
+comparer_fuites() {
+    NB_TESTS=$((NB_TESTS + 1))
+    if ! paste -d '|' "$1" "$2" | awk -F '|' '
+        {
+            split($1, a, ";"); split($2, b, ";")
+            if (a[1] != b[1]) exit 1
+            ecart = a[2] - b[2]; if (ecart < 0) ecart = -ecart
+            tolerance = (b[2] < 0 ? -b[2] : b[2]); if (tolerance < 1) tolerance = 1
+            if (ecart > 1e-5 * tolerance) exit 1
+        }' || [ "$(wc -l < "$1")" -ne "$(wc -l < "$2")" ]; then
+        echec "$3 ($(basename "$2"))"
+        diff "$2" "$1" | head -5
+    fi
+}
+
+# Lance wildwater sans afficher ses messages ; une erreur compte comme un echec
+lancer() {
+    if ! "$WILDWATER" "$@" > /dev/null 2>&1; then
+        echec "wildwater $*"
+        return 1
+    fi
+}
+
+echo " Compilation "
+make -s -C "$CODE_C_DIR" || { echo "La compilation a echoue"; exit 1; }
+
+# Fichiers compresses : seulement si gzip est present
+COMPRESSE=""
+if command -v gzip > /dev/null; then
+    COMPRESSE="$SORTIE_DIR/donnees.dat.gz"
+    gzip -c "$DONNEES" > "$COMPRESSE"
+fi
+
+# --- Histogrammes ---
+echo " Histogrammes "
+for fichier in "$DONNEES" "$DESORDRE"; do
+    if [ "$fichier" = "$DESORDRE" ]; then prefixe="desordre_"; else prefixe=""; fi
+    taille=$(stat -c %s "$fichier")
+    milieu=$((taille / 2))
+
+    for mode in max src real all; do
+        reference="$REFERENCE_DIR/${prefixe}vol_$mode.dat"
+        sortie="$SORTIE_DIR/${prefixe}vol_$mode.dat"
+
+        lancer histo "$mode" "$fichier" "$sortie" && comparer "$sortie" "$reference" "histo $mode"
+        lancer histo "$mode" "$fichier" "$sortie" --pipeline && comparer "$sortie" "$reference" "histo $mode --pipeline"
+        lancer histo "$mode" "$fichier" "$sortie" --memory 1 && comparer "$sortie" "$reference" "histo $mode --memory"
+
+        # Deux plages d'octets puis fusion des partiels
+        lancer histo "$mode" "$fichier" "$SORTIE_DIR/p0.part" --partial --bytes "0:$milieu" &&
+        lancer histo "$mode" "$fichier" "$SORTIE_DIR/p1.part" --partial --bytes "$milieu:-1" &&
+        lancer merge "$mode" "$sortie" "$SORTIE_DIR/p0.part" "$SORTIE_DIR/p1.part" &&
+        comparer "$sortie" "$reference" "histo $mode --bytes + merge"
+
+        # Deux shards d'usines puis fusion
+        lancer histo "$mode" "$fichier" "$SORTIE_DIR/s0.part" --partial --shard 0/2 &&
+        lancer histo "$mode" "$fichier" "$SORTIE_DIR/s1.part" --partial --shard 1/2 &&
+        lancer merge "$mode" "$sortie" "$SORTIE_DIR/s0.part" "$SORTIE_DIR/s1.part" &&
+        comparer "$sortie" "$reference" "histo $mode --shard + merge"
+
+        if [ -n "$COMPRESSE" ] && [ "$fichier" = "$DONNEES" ]; then
+            lancer histo "$mode" "$COMPRESSE" "$sortie" && comparer "$sortie" "$reference" "histo $mode (gzip)"
+        fi
+    done
+done
+
+# --- Fuites ---
+echo " Fuites "
+fuites() {
+    local fichier="$1" sortie="$2"
+    shift 2
+    rm -f "$sortie"
+    while read -r usine; do
+        lancer leaks "$usine" "$fichier" "$sortie" "$@" || return 1
+    done
+}
+
+for fichier in "$DONNEES" "$DESORDRE"; do
+    if [ "$fichier" = "$DESORDRE" ]; then
+        prefixe="desordre_"
+        usines=$'Plant #P\nPlant #Q'
+    else
+        prefixe=""
+        usines=$'Plant #JA200000I\nModule #CE100000E\nUnit #NM000000T\nNope'
+    fi
+    reference="$REFERENCE_DIR/${prefixe}leaks.dat"
+    sequentiel="$SORTIE_DIR/${prefixe}leaks.dat"
+
+    fuites "$fichier" "$sequentiel" <<< "$usines" &&
+        comparer_fuites "$sequentiel" "$reference" "leaks"
+
+    sortie="$SORTIE_DIR/${prefixe}leaks_pipeline.dat"
+    fuites "$fichier" "$sortie" --pipeline <<< "$usines" &&
+        comparer_fuites "$sortie" "$reference" "leaks --pipeline"
+
+    # Meme arbre quel que soit le nombre de threads : meme resultat au chiffre pres
+    for n in 1 2 3 4 8; do
+        sortie="$SORTIE_DIR/${prefixe}leaks_threads$n.dat"
+        fuites "$fichier" "$sortie" --threads "$n" <<< "$usines" &&
+            comparer_fuites "$sortie" "$reference" "leaks --threads $n" &&
+            comparer "$sortie" "$sequentiel" "leaks --threads $n = sequentiel"
+    done
+
+    if [ -n "$COMPRESSE" ] && [ "$fichier" = "$DONNEES" ]; then
+        sortie="$SORTIE_DIR/leaks_gzip.dat"
+        fuites "$COMPRESSE" "$sortie" <<< "$usines" &&
+            comparer_fuites "$sortie" "$reference" "leaks (gzip)"
+    fi
+done
+
+echo ""
+if [ "$NB_ECHECS" -ne 0 ]; then
+    echo "$NB_ECHECS echec(s) sur $NB_TESTS comparaisons"
+    exit 1
+fi
+echo "$NB_TESTS comparaisons, toutes identiques a la reference"
+exit 0